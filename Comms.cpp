@@ -9,76 +9,320 @@ extern LCDControl lcd;
 Comms::Comms() {                                                                //default constructor
     usb.begin();                                                                //start up the usb hidserial connection
     gotUser = false;
-    gotTweet = false;
+    tweetText = false;
     connected = false;                                                          //considering that this was just started, we will not be connected yet
-    versions = "$v1a$1a";                                                       //hardware and firmware versions
+    versions = "$v1a$1a$o1$t1$p1$g1$q1$k1";                                     //hardware and firmware versions, then the binary option, tweet frame and packed text formats we understand, then button gestures, the telemetry query and the 'k' host loss option
     keepAlive = 1;
+    transferLen = 0;                                                            //nothing received yet
+    transfer[0] = '\0';
+    userLen = 0;
+    userOut[0] = '\0';
+    frameLeft = 0;                                                              //not inside a tweet frame
+    loops = 0;
+    loopTotal = 0;
+    loopMax = 0;
+    pollGap = 0;
+    lastPoll = micros();
+    packets = 0;
+    dropped = 0;
+    queriedAlive = keepAlive;
 }
 
 void Comms::connect() {                                                         //used to force usb enumeration
     //something about stupid usb drivers not liking us or something
-    usbPoll();                                                                  //poll first for good measure
+    poll();                                                                     //poll first for good measure
     usb.println("%");                                                           //send a dummy packet to enumerate
 }
 
-void Comms::readComms() {                                                       //checks if we got anything new from the host, and then processes it, run this continuously
-    usbPoll();                                                                  //make sure to run this as often as possible
+//the host sends each transfer as packets of up to 31 bytes, the type char first and then a packet that's just '='.
+//a packet that's just '%' is a keepalive. only those lone ones are control packets, a longer one is data whatever it
+//starts with, so byte stuffed '$' data can start a packet with anything. the host never splits data so that a lone
+//'=' or '%' is left for the last packet, it moves one more byte into it. tweet frames only start where a transfer
+//would, a packet starting with '*' or '&' inside a transfer is data too
+
+bool Comms::readComms() {                                                       //checks if we got anything new from the host, and then processes it, run this continuously. false if there was nothing
+    PROFILE(PROFCOMMS);
+    poll();                                                                     //make sure to run this as often as possible
+    loopStart = lastPoll;                                                       //loop() starts with this, so its pass starts here too
     if (usb.available()) {                                                      //check if there's something in the usb buffer
-        usb.read((uint8_t*)usbBuffer);                                          //put the data into a string
+        usb.read((uint8_t*)usbBuffer);                                          //put the data into the packet buffer
+        packets++;
+        byte length = 0;
+        while(length < sizeof(usbBuffer) && usbBuffer[length]) {                //a packet is null terminated unless it fills the whole buffer
+            length++;
+        }
+        if(frameLeft) {                                                         //inside a tweet frame every packet is data, only a lone '%' is still a keepalive
+            if(length == 1 && usbBuffer[0] == '%') {
+                keepAlive++;
+            }
+            else {
+                addFrameData(usbBuffer, length);
+            }
+            return true;
+        }
         char inByte = (uint8_t)usbBuffer[0];                                    //first character is used to identify the data packet type
-        usbBufStr = String(usbBuffer);
+        if(length > 1 && (inByte == '=' || inByte == '%')) {                    //not a control packet, just data that starts with one
+            inByte = 0;
+        }
     
         switch (inByte) {                                                       //check what character it is, and process accordingly
-            case '=':                                                           //marks the end of the entire transfer, must always be in its own packet     
+            case '=':                                                           //marks the end of the entire transfer, must always be in its own packet
                 checkType();                                                    //process the completed data transfer
                 break;
             case '%':
                 keepAlive++;
                 break;
+            case '*':                                                           //start of a tweet frame
+            case '&':                                                           //same with packed text
+                if(!transferLen && !tweetText && startFrame(inByte, length)) {  //inside a transfer it's data that happens to look like a header
+                    break;
+                }
+                //fall through, no valid header so it's just data
             default:                                                            //this will only trigger for regular packet transfers           
-                transferOut += usbBufStr;                                       //add the current packet to the output transfer String
+                if(tweetText) {                                                 //inside a '!' transfer the text goes straight into the tweet queue
+                    framePackets++;
+                    twt.addText(usbBuffer, length);
+                }
+                else if(inByte == '!' && !transferLen && gotUser) {             //tweet transfer, ending of a new tweet, only complete once we got the user that starts it
+                    tweetText = true;
+                    gotUser = false;                                            //already got the new tweet, so reset that
+                    framePackets = 1;
+                    twt.beginTweet(userOut, userLen);                           //if that fails endTweet() says so at the '='
+                    twt.addText(usbBuffer + 1, length - 1);
+                }
+                else {
+                    append(usbBuffer, length);
+                }
                 break;
         }
+        return true;
+    }
+    return false;
+}
+
+void Comms::append(const char *data, byte length) {                             //adds packet data to the transfer buffer
+    if(length > TRANSFERSIZE - transferLen) {                                   //anything past the end of the reassembly buffer gets dropped
+        length = TRANSFERSIZE - transferLen;
+        dropped++;
     }
+    memcpy(transfer + transferLen, data, length);                               //copy the packet in at the write cursor
+    transferLen += length;
+    transfer[transferLen] = '\0';
 }
 
 void Comms::checkType() {                                                       //used to check the type of transfer
-    char type = transferOut.charAt(0);                                          //get the first char out of the transfer output, it's the transfer type
-    transferOut = transferOut.substring(1);                                     //remove the the first character, it's no longer needed in there
-    switch(type) {                                                              //check the first char of the transferOut String
+    if(tweetText) {                                                             //the end of a '!' transfer
+        tweetText = false;
+        finishTweet(true);
+        return;
+    }
+    if(transferLen == 0) {                                                      //nothing to process
+        return;
+    }
+    char type = transfer[0];                                                    //get the first char out of the transfer, it's the transfer type
+    char *data = transfer + 1;                                                  //the rest of the transfer, without the type char
+    unsigned int length = transferLen - 1;
+    switch(type) {                                                              //check the first char of the transfer
         case '@':                                                               //username transfer, also signifies the start of a new tweet
-            userOut = transferOut;                                              //put the transfer into a new String for the username
-            transferOut = "";                                                   //empty transferOut so it can accept a new transfer
+            userLen = length > USERSIZE ? USERSIZE : length;                    //keep the username, the next transfer reuses the buffer
+            memcpy(userOut, data, userLen);
+            userOut[userLen] = '\0';
             gotUser = true;                                                     //we got the user               
             break;
-        case '!':                                                               //tweet transfer, ending of a new tweet     
-            twtOut = transferOut;                                               //put the transfer into a new String for the tweet
-            transferOut = "";                                                   //empty transferOut so it can accept a new transfer
-            gotTweet = true;                                                    //we got the tweet text
-            break;
         case '$':                                                               //option transfer
-            opt.extractOption(transferOut);                                             //get the option data out of the transfer
-            transferOut = ""; 
+            if(length && (byte)data[0] == OPTBINARY) {                          //binary options come byte stuffed, undo that in place
+                length = 1 + unstuff((byte *)data + 1, length - 1);
+            }
+            opt.extractOption(data, length);                                    //apply the option data straight out of the transfer
+            break;
+        case '?':                                                               //telemetry query, no data
+            sendTelemetry();
             break;
+#ifdef PROFILING
+        case '#':                                                               //profiler dump, no data
+            sendProfile();
+            break;
+#endif
         default:
             break;
     }
-    if (gotUser & gotTweet) {                                                   //if we got both the tweet and the user
-        twt.setUser(userOut);                                                   //give the tweet handler a new user
-        twt.setTweet(twtOut);                                                   //give the tweet handler a new tweet
-        lcd.printNewTweet(true);                                                //tell LCDControl to print the new tweet
-        //already got the new tweet, so reset those vars
-        gotTweet = false;                                                       
-        gotUser = false;
-    }   
+    transferLen = 0;                                                            //empty the buffer so it can accept a new transfer
+    transfer[0] = '\0';
+}
+
+//==============================================================================
+//a tweet frame carries the user and text in one transfer with no '=' terminator:
+//  '*' uu ttt cccc user text
+//uu and ttt are the user and text lengths and cccc is the CRC-16/XMODEM of user and text, all in hex.
+//the whole header has to be in the first packet, and the host never ends a frame with a packet that's just '%'.
+//a frame can't start inside a '!' transfer, its packets are all text until the '='
+//the device answers "*e" for a damaged frame, "*l" for one that checks out but is longer than USERSIZE/TWEETSIZE and
+//"*f" when the tweet queue has no room for it, a '!' transfer gets the same "*f" when it doesn't fit. the host sends
+//the frame again after "*e" and "*f", never after "*l". an '&' frame is the same except the text is packed (see TextPack.h): ttt counts the
+//packed bytes, and the crc is still over the unpacked text. the text goes into the tweet queue as the packets come
+//in, unpacked and converted for the lcd on the way, so there's no buffer for a whole tweet in here
+
+bool Comms::startFrame(char type, byte length) {                                           //reads the frame header out of the first packet, false if it isn't one
+    long user = length >= FRAMEHEADER ? readHex(usbBuffer + 1, 2) : -1;
+    long text = readHex(usbBuffer + 3, 3);
+    long crc = readHex(usbBuffer + 6, 4);
+    if(user < 0 || text < 0 || crc < 0) {                                       //not a header we understand
+        return false;
+    }
+    frameUser = user;
+    frameText = text;
+    frameCrc = crc;
+    framePacked = type == '&';
+    frameEscape = false;
+    framePackets = 0;
+    frameLong = user > USERSIZE || (!framePacked && text > TWEETSIZE);          //too long frames still get read, just not shown
+    frameOk = true;
+    frameLeft = user + text;
+    frameCheck = 0;
+    frameGot = 0;
+    userLen = 0;
+    gotUser = false;                                                            //a frame replaces a '@' still waiting for its '!'
+    if(!frameUser && !frameLong) {
+        twt.beginTweet(userOut, 0);
+    }
+    addFrameData(usbBuffer + FRAMEHEADER, length - FRAMEHEADER);
+    return true;
+}
+
+void Comms::addFrameData(const char *data, byte length) {                       //adds packet data to the frame, finishes it once all of it is here
+    framePackets++;
+    if(length > frameLeft) {                                                    //more than the header promised
+        length = frameLeft;
+        frameOk = false;
+    }
+    frameLeft -= length;
+    byte raw = 0;                                                               //the user comes first and isn't packed, it's kept in userOut until it's all here
+    if(userLen < frameUser) {
+        raw = frameUser - userLen;
+        if(raw > length) {
+            raw = length;
+        }
+        for(byte i = 0; i < raw; i++) {
+            frameCheck = _crc_xmodem_update(frameCheck, data[i]);
+            if(userLen < USERSIZE) {
+                userOut[userLen] = data[i];
+            }
+            userLen++;
+        }
+        if(userLen == frameUser && !frameLong) {                                //the tweet gets rendered into the queue as the text comes in
+            twt.beginTweet(userOut, userLen);
+        }
+    }
+    if(framePacked) {
+        unpack((const byte *)data + raw, length - raw);
+    }
+    else {
+        addFrameText(data + raw, length - raw);
+    }
+    if(!frameLeft) {
+        finishFrame();
+    }
+}
+
+void Comms::addFrameText(const char *data, byte length) {                       //text of the frame, unpacked already
+    for(byte i = 0; i < length; i++) {
+        frameCheck = _crc_xmodem_update(frameCheck, data[i]);
+    }
+    frameGot += length;
+    if(!frameLong) {
+        twt.addText(data, length);
+    }
+}
+
+void Comms::finishFrame() {                                                     //shows the tweet if the frame checks out, otherwise tells the host
+    if(framePacked && frameGot > TWEETSIZE) {                                   //only now do we know how long the text really is
+        frameLong = true;
+    }
+    if(frameEscape || frameCheck != frameCrc) {                                 //packed text can't end halfway through an escape
+        frameOk = false;
+    }
+    if(frameOk && !frameLong) {
+        finishTweet(true);
+        return;
+    }
+    twt.endTweet(false);
+    if(frameOk) {
+        usb.println("*l");                                                      //came in fine but will never fit, sending it again won't help
+    }
+    else {
+        usb.println("*e");                                                      //frame was corrupted, the host can send it again
+    }
+    usb.println("=");
+    dropped += framePackets;
+}
+
+void Comms::finishTweet(bool keep) {                                            //queues the tweet that came in, or tells the host there was no room for it
+    if(twt.endTweet(keep)) {
+        lcd.tweetQueued();                                                      //LCDControl shows it once it's done with the ones before it
+    }
+    else {
+        usb.println("*f");                                                      //queue is full, the host can send it again later
+        usb.println("=");
+        dropped += framePackets;
+    }
+}
+
+void Comms::unpack(const byte *data, byte length) {                            //expands packed text straight into the tweet
+    for(byte i = 0; i < length; i++) {
+        byte c = data[i];
+        if(frameEscape || c < PACKFIRST) {                                      //plain byte
+            frameEscape = false;
+            addFrameText((const char *)&c, 1);
+        }
+        else if(c == PACKESCAPE) {                                              //the literal can be in the next packet
+            frameEscape = true;
+        }
+        else {                                                                  //dictionary entry
+            char entry[PACKWIDTH];
+            memcpy_P(entry, packDict + (c - PACKFIRST) * PACKWIDTH, PACKWIDTH);
+            byte n = 0;
+            while(n < PACKWIDTH && entry[n]) {
+                n++;
+            }
+            addFrameText(entry, n);
+        }
+    }
+}
+
+long Comms::readHex(const char *in, byte digits) {                              //reads a fixed number of hex digits, -1 if any of them isn't one
+    long value = 0;
+    for(byte i = 0; i < digits; i++) {
+        char c = in[i];
+        byte digit;
+        if(c >= '0' && c <= '9') {
+            digit = c - '0';
+        }
+        else if(c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        }
+        else if(c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        }
+        else {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
 }
 
 void Comms::handshake() {                                                       //used to establish a data connection with the host
     while (!connected) {                                                        //do this while we are not connected
-        usbPoll();                                                              //keep polling the USB port for any new data
+        poll();                                                                 //keep polling the USB port for any new data
+        lcd.animate();                                                          //step the boot animation if it's still playing
+        if(lcd.animating()) {                                                   //let it finish before asking the host for a handshake
+            lcd.updateLCD();
+            continue;
+        }
         usb.println("`");                                                       //continuously send this to the host so it knows the we are waiting for a handshake
         lcd.connectDisplay(true);                                               //display the connecting animation on the LCD
         inout.connectionLED(2);                                                 //blink the connection led to further signify that the device is connecting
+        lcd.updateLCD();                                                        //keep the connecting animation going out to the lcd
         if (usb.available()) {                                                  //check if we got any data from the host
             usb.read((uint8_t*)usbBuffer);                                      //read that data into usbBuffer
             if ((uint8_t)usbBuffer[0] == '~') {                                 //a "~" is the host acknowledging that it got the "`" from before
@@ -86,19 +330,146 @@ void Comms::handshake() {
             }
         }  
     }
-    delay(250);                                                                  //give the host a little time to get ready
-    char ver[8];                                                                //get a char array ready
-    versions.toCharArray(ver, 8);                                               //put that String into that new char array
-    usb.println(ver);                                                           //send the device version to the host
+    unsigned long start = millis();
+    while(millis() - start < 250) {                                             //give the host a little time to get ready, usb still needs polling meanwhile
+        poll();
+        lcd.updateLCD();
+    }
+    usb.println(versions);                                                      //send the device version to the host
     inout.connectionLED(1);                                                     //turn the connection led solid on since we're connected now
     lcd.connectDisplay(false);                                                  //show the connected notice on the lcd
 }
 
 void Comms::setConnected(bool in) {                                             //sets the connected status
     connected = in;
+    if(!connected) {                                                            //whatever was half received won't be finished now
+        frameLeft = 0;
+        transferLen = 0;
+        transfer[0] = '\0';
+        if(tweetText) {                                                         //and a frame can't start until it's cleared
+            tweetText = false;
+            twt.endTweet(false);
+        }
+    }
 }
 
-void Comms::sendBtn(char in) {                                                  //used to send button presses to the host program for processing
-    usb.println(in);
+void Comms::sendBtn(char in, char gesture) {                                    //used to send button presses to the host program for processing
+    char report[3] = {in, gesture, '\0'};                                       //button then gesture, "1l" is a long press on FN1
+    if(gesture == GESTURESHORT) {                                               //a short press is still just the button, older host programs know that one
+        report[1] = '\0';
+    }
+    usb.println(report);
     usb.println("=");
-}
\ No newline at end of file
+}
+unsigned int Comms::unstuff(byte *data, unsigned int length) {                  //undoes COBS byte stuffing in place, returns the decoded length
+    //HIDSerial drops zero bytes, so binary data travels COBS encoded: every zero is replaced by a code byte
+    //giving the distance to the next one (0xFF means 254 bytes without a zero)
+    unsigned int in = 0;
+    unsigned int out = 0;
+    while(in < length) {
+        byte code = data[in++];
+        for(byte i = 1; i < code && in < length; i++) {
+            data[out++] = data[in++];
+        }
+        if(code != 0xFF && in < length) {                                       //the last block has no zero after it
+            data[out++] = 0;
+        }
+    }
+    return out;
+}
+
+//==============================================================================
+//telemetry: a '?' transfer gets a TELEMETRYSIZE reply, '?' then these fields, each a number of 7 bit digits, most
+//significant first, with the high bit set so none of them is a zero or a line end. all but free ram cover the time
+//since the last query and stick at their largest value instead of wrapping:
+//  loop() passes (2), mean and longest awake time of a pass in us (2 each), longest gap between usbPoll() calls
+//  in us (2), keepalives (1), packets read (2), packets thrown away (1), free ram in 16 byte units (1)
+//the longest pass and the longest gap are times: below TIMEINMS they're in us, from there on TIMEINMS plus ms, so
+//the long stalls they're there for still fit in two digits
+
+void Comms::poll() {                                                            //usbPoll(), keeping track of the longest gap between calls
+    unsigned long now = micros();
+    if(now - lastPoll > pollGap) {
+        pollGap = now - lastPoll;
+    }
+    lastPoll = now;
+    usbPoll();
+}
+
+void Comms::loopDone() {                                                        //counts the loop() pass readComms() started, call it before sleeping
+    unsigned long took = micros() - loopStart;
+    loops++;
+    loopTotal += took;
+    if(took > loopMax) {
+        loopMax = took;
+    }
+}
+
+void Comms::sendTelemetry() {                                                   //answers a '?' query and starts the next count
+    char reply[TELEMETRYSIZE + 1];
+    char *out = reply;
+    *out++ = '?';
+    out = putDigits(out, loops, 2);
+    out = putDigits(out, loops ? loopTotal / loops : 0, 2);
+    out = putTime(out, loopMax);
+    out = putTime(out, pollGap);
+    out = putDigits(out, keepAlive - queriedAlive, 1);
+    out = putDigits(out, packets, 2);
+    out = putDigits(out, dropped, 1);
+    out = putDigits(out, freeRam() / 16, 1);
+    *out = '\0';
+    usb.println(reply);
+    loops = 0;
+    loopTotal = 0;
+    loopMax = 0;
+    pollGap = 0;
+    packets = 0;
+    dropped = 0;
+    queriedAlive = keepAlive;
+    lastPoll = micros();                                                        //sending the reply isn't something the next count should see
+    loopStart = lastPoll;
+}
+
+#ifdef PROFILING
+//a '#' transfer gets one line per profiler section and empties the table: '#', the section number as a digit, then
+//like above: calls (3), shortest, longest and mean call in us (2 each)
+void Comms::sendProfile() {
+    for(byte i = 0; i < PROFSECTIONS; i++) {
+        ProfStats &s = profTable[i];
+        char line[12];
+        char *out = line;
+        *out++ = '#';
+        *out++ = '0' + i;
+        out = putDigits(out, s.calls, 3);
+        out = putDigits(out, s.low, 2);
+        out = putDigits(out, s.high, 2);
+        out = putDigits(out, s.calls ? s.total / s.calls : 0, 2);
+        *out = '\0';
+        usb.println(line);
+    }
+    profReset();
+    lastPoll = micros();                                                        //like the telemetry reply, sending this isn't part of the count
+    loopStart = lastPoll;
+}
+#endif
+
+char *Comms::putDigits(char *out, unsigned long value, byte digits) {           //writes value as digits 7 bit digits, returns where the next field goes
+    unsigned long most = (1UL << (7 * digits)) - 1;
+    if(value > most) {
+        value = most;
+    }
+    for(byte i = digits; i > 0; i--) {
+        *out++ = 0x80 | ((value >> (7 * (i - 1))) & 0x7F);
+    }
+    return out;
+}
+
+char *Comms::putTime(char *out, unsigned long us) {                             //writes a time in two digits, see TIMEINMS
+    return putDigits(out, us < TIMEINMS ? us : TIMEINMS + us / 1000, 2);        //putDigits() stops at 16383, so TIMEINMS + 8191ms
+}
+
+unsigned int Comms::freeRam() {                                                 //bytes between the top of the heap and the stack
+    extern char __heap_start;                                                   //avr-libc puts the heap right after the globals
+    extern char *__brkval;                                                      //top of the heap, 0 until malloc() gets used
+    return SP - (uint16_t)(uintptr_t)(__brkval ? __brkval : &__heap_start);
+}
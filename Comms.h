@@ -7,29 +7,73 @@
 #include "IO.h"
 #include "TweetHandler.h"
 #include "LCDControl.h"
+#include "TextPack.h"
+#include "Profiler.h"
 #include <avr/wdt.h>                                                            //needed to keep the whole system alive when USB is disconnected
 #include "usbdrv.h"                                                             //the usbSofCount variable requires this (and other stuff too I think)  
+#include <util/crc16.h>                                                         //checks tweet frames
+
+#define TRANSFERSIZE 64                                                         //largest transfer we keep: options, a user, queries. tweet text goes straight into the queue
+#define FRAMEHEADER 10                                                          //'*' or '&', user length (2 hex), text length (3 hex), crc (4 hex)
+#define TELEMETRYSIZE 14                                                        //'?' reply without the line end, so it goes out in two 8 byte reports
+#define TIMEINMS 0x2000                                                         //telemetry times from this many us on are sent as this plus ms
 
 class Comms {
     public:
         Comms();
-        void readComms();
+        bool readComms();
         void handshake();
-        void sendBtn(char in);
+        void sendBtn(char in, char gesture);
         void setConnected(bool in);
         void connect();
+        void loopDone();
         unsigned long keepAlive;
     private:
         void checkType();
+        void poll();
+        void sendTelemetry();
+        void sendProfile();
+        char *putDigits(char *out, unsigned long value, byte digits);
+        char *putTime(char *out, unsigned long us);
+        unsigned int freeRam();
+        void append(const char *data, byte length);
+        bool startFrame(char type, byte length);
+        void addFrameData(const char *data, byte length);
+        void addFrameText(const char *data, byte length);
+        void finishFrame();
+        void finishTweet(bool keep);
+        void unpack(const byte *data, byte length);
+        long readHex(const char *in, byte digits);
+        unsigned int unstuff(byte *data, unsigned int length);
         HIDSerial usb;                                                          //creates a new HIDSerial instance, named usb
         char usbBuffer[32];
-        String usbBufStr;
-        String transferOut;
-        String userOut;
-        String twtOut;
-        String versions;
+        char transfer[TRANSFERSIZE + 1];                                        //reassembly buffer for the current transfer, always null terminated
+        unsigned int transferLen;                                               //write cursor into transfer
+        char userOut[USERSIZE + 1];
+        byte userLen;
+        unsigned int frameLeft;                                                 //bytes of the current tweet frame still to come, 0 outside a frame
+        byte frameUser;                                                         //user and text lengths from the frame header
+        unsigned int frameText;
+        unsigned int frameCrc;
+        unsigned int frameCheck;                                                //crc of the frame so far
+        unsigned int frameGot;                                                  //text bytes so far, unpacked
+        bool frameOk;                                                           //nothing damaged in the frame so far
+        bool frameLong;                                                         //too long for our buffers, the text doesn't go into the tweet queue
+        bool framePacked;                                                       //'&' frame, the text is packed with the TextPack dictionary
+        bool frameEscape;                                                       //the last packed byte was PACKESCAPE, the literal is still to come
+        byte framePackets;                                                      //packets the current frame or '!' transfer came in, all of them are lost if it's refused
+        unsigned long loops;                                                    //telemetry, all of it since the last query: loop() passes
+        unsigned long loopTotal;                                                //us loop() spent awake
+        unsigned long loopMax;
+        unsigned long loopStart;                                                //micros() the current loop() pass started
+        unsigned long pollGap;                                                  //longest us between two usbPoll() calls
+        unsigned long lastPoll;
+        unsigned int packets;                                                   //packets read
+        unsigned int dropped;                                                   //packets whose data got thrown away
+        unsigned long queriedAlive;                                             //keepAlive at the last query
+        const char *versions;
         bool gotUser;
-        bool gotTweet;
+        bool tweetText;                                                         //a '!' transfer is coming in
         bool connected;
 };
 
@@ -4,6 +4,27 @@
 extern Options opt;                                                             //needed for Options class access
 extern Comms comms;
 extern LCDControl lcd;                                                          //needed for LCDControl class access
+extern IO inout;
+
+//backlight pwm duty for each perceived level (gamma 2.2), so fades look even and dim colors keep their hue
+static prog_uchar PROGMEM gammaTable[256] = {
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6,
+    6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 11, 11, 11, 12,
+    12, 13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19,
+    20, 20, 21, 22, 22, 23, 23, 24, 25, 25, 26, 26, 27, 28, 28, 29,
+    30, 30, 31, 32, 33, 33, 34, 35, 35, 36, 37, 38, 39, 39, 40, 41,
+    42, 43, 43, 44, 45, 46, 47, 48, 49, 49, 50, 51, 52, 53, 54, 55,
+    56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71,
+    73, 74, 75, 76, 77, 78, 79, 81, 82, 83, 84, 85, 87, 88, 89, 90,
+    91, 93, 94, 95, 97, 98, 99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
 
 IO::IO() {                                                                      //default constructor 
     pinMode(CONLED, OUTPUT);
@@ -19,20 +40,44 @@ IO::IO() {
     digitalWrite(BLUELITE, HIGH);
     
     digitalWrite(CONTRASTPIN, HIGH);                                            //required to enable lcd contrast
-    //set up the function button debouncing
-    dbFN1 = Bounce();                                                           
-    dbFN2 = Bounce(); 
-    dbFN1.attach(FN1PIN);
-    dbFN2.attach(FN2PIN);
+    //set up the button edge queue, FN1PIN is PD4 and FN2PIN is PC3
+    buttonHead = 0;
+    buttonTail = 0;
+    buttonBusy = false;
+    buttonLost = false;
+    byte levels = readButtons();
+    for(byte b = 0; b < BUTTONS; b++) {                                         //start out wherever the buttons are now
+        buttons[b].raw = levels & (1 << b);
+        buttons[b].down = buttons[b].raw;
+        buttons[b].longSent = buttons[b].down;                                  //a button held through power on isn't a press
+        buttons[b].waiting = false;
+        buttons[b].second = false;
+        buttons[b].edgeMs = 0;
+        buttons[b].pressMs = 0;
+        buttons[b].releaseMs = 0;
+    }
+    PCMSK2 |= _BV(PCINT20);
+    PCMSK1 |= _BV(PCINT11);
+    PCICR |= _BV(PCIE2) | _BV(PCIE1);
+    //let the ADC sample the speed pot by itself, the core's init() only adds the prescaler and enable bits
+    potSum = 0;
+    potIndex = 0;
+    potFilled = false;
+    potLevel = 0;
+    ADMUX = _BV(REFS0) | (SPEEDPIN - A0);                                       //AVcc reference like analogRead() uses
+    ADCSRB = _BV(ADTS2);                                                        //auto trigger on timer0 overflow, the millis() timer
+    ADCSRA |= _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
     //set necessary variable values
     previousMillis = 0;                                                         //used within connectionLED for non-blocking delay
-    previousMillis5 = 0;                                                        //used within tweetBlink for non-blocking delay
-    previousMillis6 = 0;                                                        //used within rainbow for non-blocking delay
     blinkTime = 500;                                                            //time between connection animation state changes
     blinkState = false;                                                         //controls whether the connection led needs to change states
     blinkEnabled = false;                                                       
     currentColor = 0;                                                           //current color section of the rainbow that is being faded though
-    rainLevel = 0;                                                              //current brightness level of the backlight leds being faded
+    for(byte i = 0; i < 3; i++) {                                               //backlight off, same as the pins
+        fadeLevel[i] = 0;
+        fadeTarget[i] = 0;
+    }
+    fadeTicks = 0;                                                              //the fader's interrupt only runs while there's a fade, see fadeTo()
     blinkCount = 0;                                                             //amount of times the backlight changed colors during a tweet blink 
     runOnce = false;
     
@@ -63,100 +108,303 @@ void IO::connectionLED(byte mode) {
     }
 }
 
-void IO::checkButtons() {                                                       //checks the debounced buttons for any changes, needs to be called continuously
-    if(dbFN1.update()) {                                                        //if fn1's state changed
-        if(dbFN1.read()) {                                                      //if the button is now HIGH
-            comms.sendBtn('1');                                                 //tell comms to send button transfer '1' 
+//==============================================================================
+//buttons: the pin change interrupts only queue edges, all the debouncing and gesture work happens in checkButtons()
+
+ISR(PCINT2_vect, ISR_NOBLOCK) {                                                 //FN1, doesn't block V-USB either
+    inout.buttonEdge();
+}
+
+ISR(PCINT1_vect, ISR_NOBLOCK) {                                                 //FN2
+    inout.buttonEdge();
+}
+
+void IO::buttonEdge() {                                                         //queues the button levels with the time, runs in the pin change interrupts
+    if(buttonBusy) {                                                            //a bounce cut into the edge before it, that one's levels are stale now
+        buttonLost = true;
+        return;
+    }
+    buttonBusy = true;
+    byte head = buttonHead;
+    byte next = (head + 1) & (BTNQUEUE - 1);
+    if(next == buttonTail) {                                                    //full, checkButtons() will have to read the pins itself
+        buttonLost = true;
+    }
+    else {
+        buttonQueue[head].levels = readButtons();
+        buttonQueue[head].ms = millis();
+        buttonHead = next;                                                      //only now can checkButtons() see it
+    }
+    buttonBusy = false;
+}
+
+byte IO::readButtons() {                                                        //both button levels straight from the port registers, bit 0 is FN1
+    return (PIND & _BV(PIND4) ? 1 : 0) | (PINC & _BV(PINC3) ? 2 : 0);
+}
+
+void IO::checkButtons(bool report) {                                            //debounces the queued edges and reports any gestures, report false just keeps up with them
+    while(buttonTail != buttonHead) {                                           //every edge carries its own time, so it doesn't matter how late we get to them
+        byte tail = buttonTail;
+        applyEdge(buttonQueue[tail].levels, buttonQueue[tail].ms, report);
+        buttonTail = (tail + 1) & (BTNQUEUE - 1);
+    }
+    if(buttonLost) {                                                            //some edge is missing, take the levels as they are now
+        buttonLost = false;
+        applyEdge(readButtons(), millis(), report);
+    }
+    unsigned int now = millis();
+    for(byte b = 0; b < BUTTONS; b++) {
+        settle(b, now, report);
+        Button &k = buttons[b];
+        if(k.down && !k.longSent && (unsigned int)(now - k.pressMs) >= BTNLONG) {  //still held, no need to wait for the release
+            k.longSent = true;
+            k.second = false;
+            gesture(b, GESTURELONG, report);
+        }
+        //a second press that is still bouncing could make this a double, so only give up once the level settled
+        if(k.waiting && k.raw == k.down && (unsigned int)(now - k.releaseMs) > BTNDOUBLE) {
+            k.waiting = false;
+            gesture(b, GESTURESHORT, report);
         }
     }
-    if(dbFN2.update()) {                                                        //if fn1's state changed
-        if(dbFN2.read()) {                                                      //if the button is now HIGH
-            comms.sendBtn('2');                                                 //tell comms to send button transfer '2'
+}
+
+void IO::applyEdge(byte levels, unsigned int ms, bool report) {                 //takes one edge into the debouncing
+    for(byte b = 0; b < BUTTONS; b++) {
+        settle(b, ms, report);                                                  //whatever held until this edge counts first
+        bool level = levels & (1 << b);
+        if(level != buttons[b].raw) {
+            buttons[b].raw = level;
+            buttons[b].edgeMs = ms;
         }
     }
 }
 
-int IO::checkPot() {                                                            //used to check the speed pot position, should be called continuously
-    return analogRead(SPEEDPIN) / 2;
+void IO::settle(byte b, unsigned int at, bool report) {                         //makes the last edge count if its level held long enough by time at
+    Button &k = buttons[b];
+    if(k.raw == k.down || (unsigned int)(at - k.edgeMs) < BTNDEBOUNCE) {
+        return;
+    }
+    k.down = k.raw;
+    if(k.down) {                                                                //pressed, HIGH like it always was
+        press(b, k.edgeMs, report);
+    }
+    else {
+        release(b, k.edgeMs, report);
+    }
+}
+
+void IO::press(byte b, unsigned int at, bool report) {
+    Button &k = buttons[b];
+    if(k.waiting) {
+        k.waiting = false;
+        if((unsigned int)(at - k.releaseMs) <= BTNDOUBLE) {
+            k.second = true;
+        }
+        else {                                                                  //too late for a double, the first press was a short one after all
+            gesture(b, GESTURESHORT, report);
+        }
+    }
+    k.pressMs = at;
+    k.longSent = false;
+}
+
+void IO::release(byte b, unsigned int at, bool report) {
+    Button &k = buttons[b];
+    if(k.longSent) {                                                            //already reported while it was held
+        return;
+    }
+    if((unsigned int)(at - k.pressMs) >= BTNLONG) {                             //the whole press went by before checkButtons() got to it
+        k.second = false;
+        gesture(b, GESTURELONG, report);
+    }
+    else if(k.second) {
+        k.second = false;
+        gesture(b, GESTUREDOUBLE, report);
+    }
+    else {
+        k.waiting = true;
+        k.releaseMs = at;
+    }
+}
+
+void IO::gesture(byte b, char type, bool report) {
+    if(report) {
+        comms.sendBtn('1' + b, type);                                           //button transfers are '1' and '2'
+    }
+}
+
+//==============================================================================
+//speed pot: nothing waits on the ADC anymore, checkPot() only looks at what its interrupt averaged
+
+ISR(ADC_vect, ISR_NOBLOCK) {                                                    //the next conversion is a whole millisecond away, so no chance of it cutting into itself
+    inout.potSample(ADC);
+}
+
+void IO::potSample(unsigned int sample) {                                       //adds one ADC reading to the moving average, runs in the ADC interrupt
+    if(!potFilled) {                                                            //start the average at the first reading instead of working up from 0
+        for(byte i = 0; i < POTAVERAGE; i++) {
+            potRing[i] = sample;
+        }
+        potSum = sample * POTAVERAGE;
+        potFilled = true;
+        return;
+    }
+    potSum += sample - potRing[potIndex];
+    potRing[potIndex] = sample;
+    potIndex = (potIndex + 1) & (POTAVERAGE - 1);
+}
+
+int IO::checkPot() {                                                            //the speed pot position, only changes once the knob really moved
+    uint8_t oldSREG = SREG;                                                     //potSum is 2 bytes, the interrupt could change it halfway through reading
+    cli();
+    int level = potSum / POTAVERAGE;
+    SREG = oldSREG;
+    //ADC noise moves the average a count or two, ignore that. the ends still have to be reachable though
+    if(potFilled && (abs(level - potLevel) > POTHYSTERESIS || ((level == 0 || level == 1023) && level != potLevel))) {
+        potLevel = level;
+    }
+    return potLevel / 2;
 }
 
 //==============================================================================
 
 void IO::setBacklight(uint8_t r, uint8_t g, uint8_t b, byte brightness) {       //set the backlight to a specific color and brightness
-    r = map(r, 0, 255, 0, brightness);
-    g = map(g, 0, 255, 0, brightness);
-    b = map(b, 0, 255, 0, brightness);
-
-    //common anode so invert
-    r = map(r, 0, 255, 255, 0);
-    g = map(g, 0, 255, 255, 0);
-    b = map(b, 0, 255, 255, 0);
-    
-    red = r;
-    green = g;
-    blue = b;
+    fadeTo(r, g, b, brightness, 0);
+}
 
-    analogWrite(REDLITE, red);
-    analogWrite(GREENLITE, green);
-    analogWrite(BLUELITE, blue);
+//==============================================================================
+//backlight fader: fadeTo() works out the steps, the timer2 overflow interrupt takes one every 2.04ms
+
+ISR(TIMER2_OVF_vect, ISR_NOBLOCK) {                                             //V-USB's interrupt has to be able to cut in at any time, so this one doesn't block it
+    inout.fadeTick();
 }
 
-void IO::tweetBlink() {                                                         //used to trigger a tweet blink, should be called while waiting in the tweet beginning
-    if (opt.getBlink()) {                                                       //check if tweetblink is enabled
-        if(opt.getReadyBlink()) {                                               //check if we are currently blinking
-            unsigned long currentMillis = millis();
-            if(currentMillis - previousMillis5 > opt.getBlinkSpd()) {           //if it's time to change the backlight color (blink)
-                previousMillis5 = currentMillis;
-                if(blinkCount == 5) {                                           //done blinking
-                    blinkCount = 0;                                             //reset blink count
-                    opt.setReadyBlink(false);                                   //no longer blinking
-                }
-                else if(blinkCount % 2 == 0) {                                  //on even numbered blinkcounts, set the backlight to the normal color
-                    opt.updateCol();
-                    blinkCount++;
-                }
-                else {                                                          //on odd numbered blinkcounts, set the backlight to the blink color
-                    opt.updateBlinkCol();
-                    blinkCount++;
-                } 
-            }
+void IO::fadeTo(byte r, byte g, byte b, byte brightness, unsigned long ms) {    //fades the backlight to a color and brightness over ms, 0 sets it right away
+    byte target[3] = {scale(r, brightness), scale(g, brightness), scale(b, brightness)};
+    unsigned long ticks = FADETICKS(ms);
+    unsigned long level[3];
+    long delta[3] = {0, 0, 0};
+    uint8_t oldSREG = SREG;                                                     //stop the fader and see where it got to, it can't step without fadeTicks
+    cli();
+    fadeTicks = 0;
+    for(byte i = 0; i < 3; i++) {
+        level[i] = fadeLevel[i];
+    }
+    SREG = oldSREG;
+    for(byte i = 0; i < 3; i++) {                                               //the divisions take ~100us, V-USB can't wait that long for its interrupt
+        if(ticks) {
+            delta[i] = (((long)target[i] << 16) - (long)level[i]) / (long)ticks;
+        }
+        else {
+            level[i] = (unsigned long)target[i] << 16;
         }
     }
+    cli();                                                                      //the fader can't step a half set up fade
+    for(byte i = 0; i < 3; i++) {
+        fadeTarget[i] = target[i];
+        fadeDelta[i] = delta[i];
+        fadeLevel[i] = level[i];
+    }
+    fadeTicks = ticks;
+    if(ticks) {
+        TIMSK2 |= _BV(TOIE2);                                                   //interrupts only get turned on once the core is set up, so this is safe from constructors too
+    }
+    else {
+        writeLevels();
+    }
+    SREG = oldSREG;                                                             //this also runs from constructors, before the core turned interrupts on
 }
 
-void IO::rainbow() {                                                            //controls the backlight's rainbow mode, must be ran continuously
-    if(opt.getRainbow()) {
-        if(!runOnce) {                                                          //set the first rainbow color if this is the first time
-            opt.setCol(rainLevel, 0, 255-rainLevel);
-            runOnce = true;
+bool IO::fading() {
+    uint8_t oldSREG = SREG;                                                     //fadeTicks is 4 bytes, the interrupt could change it halfway through reading
+    cli();
+    bool busy = fadeTicks != 0;
+    SREG = oldSREG;
+    return busy;
+}
+
+void IO::fadeTick() {                                                           //takes one fader step, runs in the timer2 overflow interrupt
+    if(!fadeTicks) {
+        return;
+    }
+    fadeTicks--;
+    if(!fadeTicks) {                                                            //done, don't wake the cpu every 2ms for nothing
+        TIMSK2 &= ~_BV(TOIE2);
+    }
+    for(byte i = 0; i < 3; i++) {
+        if(fadeTicks) {
+            fadeLevel[i] += fadeDelta[i];
         }
-        unsigned long currentMillis = millis();
-        if(currentMillis - previousMillis6 > opt.getRainSpd()) {                //if it's time to advance colors
-            previousMillis6 = currentMillis;
-            if(rainLevel < 255) {                                              //fade through each color section 255 times
-                switch(currentColor) {                                          //fade through each different color section
-                    case 0:
-                        opt.setCol(rainLevel, 0, 255-rainLevel);
-                        break;
-                    case 1:
-                        opt.setCol(255-rainLevel, rainLevel, 0);
-                        break;
-                    case 2:
-                        opt.setCol(0, 255-rainLevel, rainLevel);
-                        break;
-                }
-                rainLevel++;
-            }
-            else {
-                rainLevel = 0;                                                  //reset the rainlevel
-                currentColor++;                                                 //move to the next color section
-                if(currentColor == 3) {                                         //go to the beginning if needed
-                    currentColor = 0;
-                }
-            }
+        else {                                                                  //last step lands exactly on the target, whatever the rounding did
+            fadeLevel[i] = (unsigned long)fadeTarget[i] << 16;
         }
     }
-    else {                                                                      //make sure runOnce is set to false when not rainbowing
+    writeLevels();
+}
+
+byte IO::scale(byte c, byte brightness) {                                       //color channel at a brightness, a multiply and a shift instead of map()'s division
+    return ((unsigned int)c * (brightness + 1)) >> 8;
+}
+
+void IO::writeLevels() {                                                        //puts the fader levels out on the backlight pins
+    //straight into the timers' compare registers, analogWrite() is too slow for an interrupt. common anode so invert
+    OCR1A = 255 - pgm_read_byte(&gammaTable[fadeLevel[0] >> 16]);               //REDLITE
+    OCR0B = 255 - pgm_read_byte(&gammaTable[fadeLevel[1] >> 16]);               //GREENLITE
+    OCR0A = 255 - pgm_read_byte(&gammaTable[fadeLevel[2] >> 16]);               //BLUELITE
+    TCCR1A |= _BV(COM1A1);                                                      //hand the pins to the timers, until now they were held high so nothing flashed at power on
+    TCCR0A |= _BV(COM0A1) | _BV(COM0B1);
+}
+
+unsigned int IO::tweetBlink() {                                                 //steps a tweet blink, runs as a task and returns the ms until it's due again
+    PROFILE(PROFBLINK);
+    if(!opt.getBlink() || !opt.getReadyBlink()) {                               //tweetblink is disabled or we aren't blinking right now
+        return IDLEPOLL;
+    }
+    if(blinkCount == 5) {                                                       //done blinking
+        blinkCount = 0;                                                         //reset blink count
+        opt.setReadyBlink(false);                                               //no longer blinking
+    }
+    else if(blinkCount % 2 == 0) {                                              //on even numbered blinkcounts, set the backlight to the normal color
+        opt.updateCol();
+        blinkCount++;
+    }
+    else {                                                                      //on odd numbered blinkcounts, set the backlight to the blink color
+        opt.updateBlinkCol();
+        blinkCount++;
+    }
+    return opt.getBlinkSpd() + 1;                                               //the old millis() check waited for more than getBlinkSpd()
+}
+
+unsigned int IO::rainbow() {                                                    //steps the backlight's rainbow mode, runs as a task and returns the ms until it's due again
+    PROFILE(PROFRAINBOW);
+    if(!opt.getRainbow()) {                                                     //make sure runOnce is set to false when not rainbowing
         runOnce = false;
+        return IDLEPOLL;
+    }
+    if(!runOnce) {                                                              //set the first rainbow color if this is the first time
+        opt.setCol(0, 0, 255);
+        currentColor = 0;
+        runOnce = true;
+    }
+    else if(fading()) {                                                         //the fader is still on its way through this color section
+        return IDLEPOLL;
+    }
+    unsigned long ms = 256UL * (opt.getRainSpd() + 1);                          //each section used to be 256 steps of getRainSpd()+1 ms
+    switch(currentColor) {                                                      //fade through each different color section
+        case 0:
+            opt.fadeCol(255, 0, 0, ms);
+            break;
+        case 1:
+            opt.fadeCol(0, 255, 0, ms);
+            break;
+        case 2:
+            opt.fadeCol(0, 0, 255, ms);
+            break;
+    }
+    currentColor++;                                                             //move to the next color section
+    if(currentColor == 3) {                                                     //go to the beginning if needed
+        currentColor = 0;
     }
+    return IDLEPOLL;
 }
\ No newline at end of file
@@ -2,10 +2,13 @@
 #define	IO_H
 
 #include <Arduino.h>
-#include <Bounce.h>                                                             //required for debouncing
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
 #include "Options.h"
 #include "LCDControl.h"
 #include "Comms.h"
+#include "Scheduler.h"
+#include "Profiler.h"
 
 #define CONLED A4                                                               //connection led pin
 #define FN1PIN 4                                                                //FN1 button
@@ -17,35 +20,84 @@
 #define REDLITE 9
 #define GREENLITE 5
 #define BLUELITE 6
+//the backlight fader steps on every timer2 overflow, every 2.04ms with timer2 in phase correct pwm at prescaler 64 like the
+//Arduino core sets it up. pins 3 and 11 would be the ones to lose pwm, and the lcd only uses 11 as a plain output
+#define FADETICKS(ms) ((ms) * 25 / 51)                                          //fader steps in ms milliseconds
+//the buttons: pin change interrupts queue every edge with its time, checkButtons() debounces them and works out the gestures
+#define BUTTONS 2                                                               //FN1 and FN2
+#define BTNQUEUE 16                                                             //edges the queue holds, a power of two. a bouncy press takes a few
+#define BTNDEBOUNCE 10                                                          //ms a level has to hold before it counts
+#define BTNLONG 600                                                             //ms held down for a long press
+#define BTNDOUBLE 300                                                           //ms after a release that a second press makes it a double press
+//what sendBtn() reports after the button number, a short press is just the number like it always was
+#define GESTURESHORT 's'
+#define GESTURELONG 'l'
+#define GESTUREDOUBLE 'd'
+//the speed pot: the ADC converts on every timer0 overflow (1.024ms) by itself, its interrupt keeps a moving average
+#define POTAVERAGE 8                                                            //readings averaged, a power of two
+#define POTHYSTERESIS 4                                                         //ADC counts the average has to move before the speed changes
+
+struct ButtonEvent {                                                            //one edge on the button pins
+    byte levels;                                                                //both buttons right after the edge, bit 0 is FN1
+    unsigned int ms;                                                            //millis() when it happened
+};
+
+struct Button {                                                                 //debounce and gesture state of one button
+    bool raw;                                                                   //level after the last edge
+    bool down;                                                                  //debounced level
+    bool longSent;                                                              //this press was already reported as long
+    bool waiting;                                                               //released after a short press, a second one would make it a double
+    bool second;                                                                //down for the second press of a double
+    unsigned int edgeMs;                                                        //time of the last edge
+    unsigned int pressMs;
+    unsigned int releaseMs;
+};
 
 class IO {
     public:
         IO();
-        void checkButtons();
+        void checkButtons(bool report);
+        void buttonEdge();
+        void potSample(unsigned int sample);
         int checkPot();
         void connectionLED(byte mode);
         void setBacklight(uint8_t r, uint8_t g, uint8_t b, byte brightness);
-        void tweetBlink();
-        void rainbow();
+        void fadeTo(byte r, byte g, byte b, byte brightness, unsigned long ms);
+        bool fading();
+        void fadeTick();
+        unsigned int tweetBlink();
+        unsigned int rainbow();
     private:
+        byte scale(byte c, byte brightness);
+        void writeLevels();
+        byte readButtons();
+        void applyEdge(byte levels, unsigned int ms, bool report);
+        void settle(byte b, unsigned int at, bool report);
+        void press(byte b, unsigned int at, bool report);
+        void release(byte b, unsigned int at, bool report);
+        void gesture(byte b, char type, bool report);
         unsigned long previousMillis;
-        unsigned long previousMillis5;
-        unsigned long previousMillis6;
         int blinkTime;                                           
         bool blinkState;                                             
         bool blinkEnabled;
         bool runOnce;
         byte blinkSpeed;                                                        
         byte currentColor;                                                  
-        byte rainLevel;
-        byte red;
-        byte green;
-        byte blue;
-        byte bRed;
-        byte bGreen;
-        byte bBlue;
-        Bounce dbFN1;
-        Bounce dbFN2;
+        unsigned long fadeLevel[3];                                             //red, green and blue before the gamma table, 8.16 fixed point
+        long fadeDelta[3];                                                      //added to fadeLevel every fader step
+        byte fadeTarget[3];
+        volatile unsigned long fadeTicks;                                       //fader steps left, 0 when the backlight is where it should be
+        volatile ButtonEvent buttonQueue[BTNQUEUE];                             //only the interrupt adds to it and only checkButtons() takes from it, so no locking
+        volatile byte buttonHead;                                               //next free slot, the interrupt's
+        volatile byte buttonTail;                                               //oldest queued edge, checkButtons()'s
+        volatile bool buttonBusy;                                               //an edge is being queued right now
+        volatile bool buttonLost;                                               //an edge didn't make it into the queue, the pins have to be read again
+        Button buttons[BUTTONS];
+        volatile unsigned int potRing[POTAVERAGE];                              //the last readings, potSum is their total
+        volatile unsigned int potSum;
+        volatile byte potIndex;                                                 //oldest reading, the next one replaces it
+        volatile bool potFilled;                                                //the first reading filled the whole ring
+        int potLevel;                                                           //last average that made it through the hysteresis
         byte blinkCount;               
 };
 
@@ -6,183 +6,412 @@ extern Options opt;
 extern TweetHandler twt;
 extern LiquidCrystal lcdc;
 
-//custom lcd characters for the logo
-static prog_char PROGMEM top1[] = {0x1,0x1,0x3,0x3,0x7,0x7,0x3,0x1};
-static prog_char PROGMEM top2[] = {0x10,0x10,0x18,0x18,0x1c,0x1c,0x18,0x10};
-static prog_char PROGMEM left2[] = {0x8,0x1c,0x1e,0x1e,0x1e,0x18,0x0,0x0};
-static prog_char PROGMEM left1[] = {0x0,0x0,0x0,0x1,0x3,0x7,0xf,0x18};
-static prog_char PROGMEM right2[] = {0x2,0x7,0xf,0xf,0xf,0x3,0x0,0x0};
-static prog_char PROGMEM right1[] = {0x0,0x0,0x0,0x10,0x18,0x1c,0x1e,0x3};
+//custom lcd characters, indexed by glyph id (see TweetHandler.h)
+static prog_char PROGMEM glyphs[GLYPHCOUNT][8] = {
+    {0x1,0x1,0x3,0x3,0x7,0x7,0x3,0x1},                                          //logo top left
+    {0x10,0x10,0x18,0x18,0x1c,0x1c,0x18,0x10},                                  //logo top right
+    {0x0,0x0,0x0,0x1,0x3,0x7,0xf,0x18},                                         //logo left wing
+    {0x8,0x1c,0x1e,0x1e,0x1e,0x18,0x0,0x0},
+    {0x2,0x7,0xf,0xf,0xf,0x3,0x0,0x0},                                          //logo right wing
+    {0x0,0x0,0x0,0x10,0x18,0x1c,0x1e,0x3},
+    {0x0,0x10,0x8,0x4,0x2,0x1,0x0,0x0},                                         //backslash
+    {0x0,0x0,0x0,0xd,0x12,0x0,0x0,0x0},                                         //tilde
+    {0x2,0x4,0xe,0x11,0x1f,0x10,0xe,0x0},                                       //e acute
+    {0x8,0x4,0xe,0x11,0x1f,0x10,0xe,0x0},                                       //e grave
+    {0x8,0x4,0xe,0x1,0xf,0x11,0xf,0x0},                                         //a grave
+    {0x0,0xe,0x10,0x10,0x11,0xe,0x4,0xc},                                       //c cedilla
+    {0x6,0x9,0x1c,0x8,0x1c,0x9,0x6,0x0},                                        //euro
+    {0x0,0x0,0x0,0x0,0x0,0x0,0x15,0x0},                                         //ellipsis
+    {0x0,0xa,0x1f,0x1f,0xe,0x4,0x0,0x0},                                        //heart
+    {0x0,0xa,0xa,0x0,0x11,0xe,0x0,0x0}                                          //smiley
+};
 
 LCDControl::LCDControl(int widthIn) {                                           //constructor, wants the lcdwidth  
     LCDWIDTH = widthIn;                                                         //character width of the LCD
     lcdc.begin(LCDWIDTH, 2);                                                    //get that LCD going  
+    memset(shown, ' ', sizeof(shown));                                          //begin() leaves the lcd cleared
+    opHead = 0;                                                                 //nothing queued yet
+    opCount = 0;
+    opProgress = 0;
+    displayDue = false;
+    displayOn = true;
+    frameDue = false;
+    frameClear();
+    lcdCol = 0;
+    lcdRow = 0;
     ranOnce = false;                                                            //used in connectDisplay
     animCount = 0;                                                              //used in connectAnim
     previousMillis = 0;                                                         //used in printBegin
     lcdPos = 0;                                                                 //stores the current position of the scrolling lcd text
+    scrollStart = 0;
+    scrollBase = 0;
     textSpeed = 0;                                                              //final speed value taken from the speed potentiometer
     waitforbegin = 0;                                                           //stores if we are waiting for the beginning of the text
+    sequence = SEQNONE;                                                         //no display sequence running
+    wakeBrightness = 0;
+    for(byte i = 0; i < CGRAMSLOTS; i++) {                                      //no custom chars loaded yet
+        slotGlyph[i] = EMPTYSLOT;
+        slotOrder[i] = i;
+    }
 }
 
 void LCDControl::printNewTweet(bool current) {                                  //used to print a new tweet, needs to know if this is the current tweet or not
-    clearRow(0);                                                                //clear the username row to prepare it for an update
     opt.setReadyBlink(true);                                                    //trigger a tweetblink, if enabled
-    if(current) {                                                               //if we are on the current tweet
-        currentTweet = true;                                                    //let the rest of the class know
-        lcdc.print(twt.getUser());                                              //print the username, don't need to do anything to it 
-        printBegin(twt.getTweetBegin());                                        //print the beginning of the tweet and do further processing, give it the beginning
-    }
-    else {                                                                      //if we are on the previous tweet
-        currentTweet = false;                                                   //let the rest of the class know
-        lcdc.print(twt.getPrevUser());                                          //print the previous username, don't need to do anything to it
-        printBegin(twt.getPrevBegin());                                         //print the beginning of the tweet and do further processing, give it the previous beginning
-    }
+    showTweet(current);
+}
+
+void LCDControl::showTweet(bool current) {                                      //puts a tweet up without the tweet blink
+    clearRow(0);                                                                //clear the username row to prepare it for an update
+    currentTweet = current;                                                     //let the rest of the class know which tweet we are on
+    frameWrite(twt.getUser(current), twt.getUserLength(current));               //print the username, don't need to do anything to it
+    printBegin();                                                               //print the beginning of the tweet and do further processing
 }
 
-void LCDControl::printBegin(String begin) {                                     //prints the beginning of a tweet, and then enables scrolling if necessary
+void LCDControl::printBegin() {                                                 //prints the beginning of a tweet, and then enables scrolling if necessary
     section = 0;                                                                //let the scrolltext method know to start at section 0
+    previousMillis = millis();                                                  //the read time counts from now, scrolling or not
+    twtLength = twt.getTweetLength(currentTweet);                               //save the tweet length for shiftText
     if(twt.useScroll(currentTweet)) {                                           //ask tweethandler if scrolling is necessary
         scroll = true;                                                          //enable scrolling
         printedBegin = true;                                                    //let the program know the beginning was already printed
-        previousMillis = millis();                                              //set previousMillis to the current time, needed for new tweets made after this one
     }
     else {                                                                      //if scrolling is not necessary
         scroll = false;                                                         //disable scrolling
     }
-    clearRow(1);                                                                //clear the bottom row
-    lcdc.print(begin);                                            //print the beginning of the tweet
-    
+    frameCursor(0, 1);                                                          //the text is padded to LCDWIDTH, so it covers the whole bottom row
+    frameWrite(twt.getTweet(currentTweet), LCDWIDTH);                           //print the beginning of the tweet
+    flush();                                                                    //send the changes to the lcd
 }
 
 void LCDControl::clearRow(byte row) {                                           //used to clear individual rows, give it the row number
-    lcdc.setCursor(0, row);                                                     //set the row to start clearing
-    for(int i = 0;i <= LCDWIDTH; i++) {                                         //for each column in the row
-        lcdc.print(" ");                                                        //print a space over it, essentially clearing it
-    }
-    lcdc.setCursor(0, row);                                                     //reset cursor position
+    memset(frame[row], ' ', LCDWIDTH);                                          //blank the row in the frame, flush() sends what changed
+    frameCursor(0, row);                                                        //reset cursor position
 }
 
 //==============================================================================
+//all output is drawn into frame first, flush() then sends only the cells that differ from what the lcd shows
 
-void LCDControl::scrollTweet() {                                                //used to scroll the tweet text, must be continuously called
-    if(scroll) {
-        switch(section) {
-            case 0: {                                                           //beginning of tweet section
-                if(printedBegin) {                                              //if we already printed the beginning
-                    unsigned long currentMillis1 = millis();
-                    if(currentMillis1 - previousMillis > opt.getReadTime()) {   //wait for the user read time to elapse
-                        previousMillis = currentMillis1;
-                        section++;                                              //done waiting, allow the program to go to the next section
-                        lcdPos = 0;                                             //reset the lcdPos var, needs to start at 0 after the beginning
-                    }
-                }
-                else {                                                          //did not print the beginning yet
-                    if(currentTweet) {                                          //if we are on the current tweet
-                        printBegin(twt.getTweetBegin());                        //print the beginning
-                    }
-                    else {                                                      //if we are on the previous tweet
-                        printBegin(twt.getPrevBegin());                         //print the previous beginning
-                    }
-                }
-                break;
+void LCDControl::frameCursor(byte col, byte row) {                              //moves the frame's write position
+    frameCol = col;
+    frameRow = row;
+}
+
+void LCDControl::frameWrite(const char *text, unsigned int length) {            //draws length chars at the write position, clipped to the row
+    byte from = frameCol;
+    while(length-- && frameCol < LCDWIDTH) {
+        frame[frameRow][frameCol++] = *text++;
+    }
+    for(byte c = from; c < frameCol; c++) {                                     //swap custom glyphs for their CGRAM slot, after the old cells are gone so their slots can be reused
+        byte glyph = frame[frameRow][c] - GLYPHFIRST;
+        if(glyph < GLYPHCOUNT) {
+            frame[frameRow][c] = glyphSlot(glyph);
+        }
+    }
+}
+
+void LCDControl::framePrint_P(PGM_P text) {                                    //draws a null terminated string kept in flash, so the fixed messages take no ram
+    while(char c = pgm_read_byte(text++)) {
+        frameWrite(&c, 1);
+    }
+}
+
+void LCDControl::framePrint(char c) {                                           //draws a single char (custom glyphs are GLYPHFIRST + glyph id)
+    frameWrite(&c, 1);
+}
+
+void LCDControl::frameClear() {                                                 //blanks the whole frame
+    memset(frame, ' ', sizeof(frame));
+    frameCursor(0, 0);
+}
+
+void LCDControl::flush() {                                                      //marks the frame for sending, updateLCD() does the actual work
+    frameDue = true;
+}
+
+bool LCDControl::sendFrame(byte &budget) {                                      //sends changed cells until the budget runs out, true once the lcd matches frame
+    for(byte r = 0; r < 2; r++) {
+        for(byte c = 0; c < LCDWIDTH; c++) {
+            if(frame[r][c] == shown[r][c]) {                                    //cell is already right
+                continue;
             }
-            case 1:  {                                                          //scrolling section
-                if(opt.getScroll()) {
-                    unsigned long currentMillis2 = millis();
-                    if(currentMillis2 - previousMillis > textSpeed) {               //check if it's time to shift the text
-                        previousMillis = currentMillis2;
-                        shiftText();                                                //shift the text by one                                                  
-                    }
+            if(lcdRow != r || lcdCol != c) {                                    //only move the cursor when the address counter isn't there already
+                if(budget < 2) {                                                //no point moving the cursor without writing
+                    return false;
                 }
-                break;
+                lcdc.setCursor(c, r);
+                lcdRow = r;
+                lcdCol = c;
+                budget--;
             }
-            case 2:   {                                                         //end of tweet section
-                unsigned long currentMillis3 = millis();
-                if(currentMillis3 - previousMillis > opt.getReadTime()) {       //wait for the user read time to elapse
-                    previousMillis = currentMillis3;
-                    section = 0;                                                //done waiting, go back to section 0
-                    printedBegin = false;
-                }
-                break;
+            if(!budget) {
+                return false;
             }
+            lcdc.write((uint8_t)frame[r][c]);
+            shown[r][c] = frame[r][c];
+            lcdCol++;
+            budget--;
+        }
+    }
+    return true;
+}
+
+//==============================================================================
+//lcd output waits until updateLCD() and gets sent a few bus transfers at a time, so no single call blocks for long.
+//custom char loads go first, then the display on/off state, then the frame, so the frame never shows a glyph
+//before it's loaded. only the loads need a queue and it holds one per CGRAM slot, so it can't fill up
+
+void LCDControl::setDisplay(bool on) {                                          //turns the lcd on or off, the last state asked for wins
+    displayOn = on;
+    displayDue = true;
+}
+
+void LCDControl::updateLCD() {                                                  //sends at most LCDBUDGET bus transfers, must be called continuously
+    drainLCD(LCDBUDGET);
+}
+
+void LCDControl::drainLCD(byte budget) {                                        //sends pending output until budget bus transfers are used up
+    while(budget && opCount) {                                                  //load custom chars from progmem, one row per transfer
+        LCDOp &op = ops[opHead];
+        if(opProgress == 0) {
+            lcdc.command(0x40 | (op.slot << 3));                                //point the address counter at the char's CGRAM slot
+        }
+        else {
+            lcdc.write(pgm_read_byte(op.data + opProgress - 1));
+        }
+        budget--;
+        lcdRow = NOCURSOR;                                                      //the address counter is in CGRAM now
+        if(++opProgress == 9) {                                                 //move on to the next char
+            opHead = (opHead + 1) % LCDQUEUE;
+            opCount--;
+            opProgress = 0;
+        }
+    }
+    if(budget && displayDue) {                                                  //turn the lcd on or off
+        if(displayOn) {
+            lcdc.display();
+        }
+        else {
+            lcdc.noDisplay();
         }
+        displayDue = false;
+        budget--;
+    }
+    if(budget && frameDue) {                                                    //bring the lcd up to date with frame
+        frameDue = !sendFrame(budget);
     }
 }
 
-void LCDControl::shiftText() {                                                  //used to shift the tweet text by one column
-    if(currentTweet) {                                                          //if we are on the current tweet
-        twtLength = twt.getTweetLength();                                       //save the tweet length
+//==============================================================================
+
+void LCDControl::tweetQueued() {                                                //called when a new tweet got queued, shows it right away if nothing else is up
+    if(!twt.hasCurrent() && twt.nextTweet()) {
+        printNewTweet(true);
     }
-    else {                                                                      //if we are on the previous tweet
-        twtLength = twt.getPrevLength();                                        //save the previous tweet length
+}
+
+bool LCDControl::showNext() {                                                   //moves on to the next queued tweet, false if there is none or the previous tweet is up
+    if(!currentTweet || !twt.nextTweet()) {
+        return false;
     }
-    if (lcdPos <= (twtLength - LCDWIDTH)) {                            
-        //(subtracted LCDWIDTH since we want the ending to use all of LCDWIDTH)
-        if(currentTweet) {                                                      //get the current tweet
-            subTweet = twt.getTweet();
+    printNewTweet(true);
+    return true;
+}
+
+unsigned int LCDControl::scrollTweet() {                                        //scrolls the tweet text, runs as a task and returns the ms until it's due again
+    PROFILE(PROFSCROLL);
+    if(!scroll) {                                                               //the whole tweet fits, move on once it was up for the read time and another one is waiting
+        if(!currentTweet || !twt.getPending()) {
+            return IDLEPOLL;
         }
-        else {                                                                  //or get the previous tweet
-            subTweet = twt.getPrevTweet();
+        unsigned int wait = waitFor(opt.getReadTime());
+        if(wait) {
+            return wait;
         }
-        subTweet = subTweet.substring(lcdPos, (lcdPos + LCDWIDTH));             //create a substring from the current position to LCDWIDTH chars ahead
-        lcdc.setCursor(0, 1);                                                   //make sure we print on the bottom row
-        lcdc.print(subTweet);                                                   //printed the shifted substring
-        lcdPos++;                                                               //increase lcdPos by one
+        showNext();
+        return 0;
     }
-    if(lcdPos == ((twtLength - LCDWIDTH)+1)) {                                  //check if we are at the end of the text to be shifted
-        section++;                                                              //we are done here, go to the next section
+    switch(section) {
+        case 0: {                                                               //beginning of tweet section
+            if(!printedBegin) {                                                 //did not print the beginning yet
+                printBegin();                                                   //print the beginning
+            }
+            unsigned int wait = waitFor(opt.getReadTime());                     //wait for the user read time to elapse
+            if(wait) {
+                return wait;
+            }
+            section++;                                                          //done waiting, allow the program to go to the next section
+            lcdPos = 0;                                                         //reset the lcdPos var, needs to start at 0 after the beginning
+            scrollBase = 0;                                                     //the scroll runs on the clock from here
+            scrollStart = millis();
+            return textSpeed + 1;
+        }
+        case 1: {                                                               //scrolling section
+            if(!opt.getScroll()) {                                              //scrolling is paused, it carries on from here with a whole step once it's back
+                scrollBase = lcdPos;
+                scrollStart = millis();
+                return IDLEPOLL;
+            }
+            return shiftText();                                                 //move the text along
+        }
+        case 2: {                                                               //end of tweet section
+            unsigned int wait = waitFor(opt.getReadTime());                     //wait for the user read time to elapse
+            if(wait) {
+                return wait;
+            }
+            section = 0;                                                        //done waiting, go back to section 0
+            printedBegin = false;
+            showNext();                                                         //the next queued tweet takes over, if there is one
+            return 0;                                                           //print the beginning on the next pass
+        }
+    }
+    return IDLEPOLL;
+}
+
+unsigned int LCDControl::waitFor(unsigned int period) {                         //returns the ms left until more than period passed since previousMillis
+    unsigned long elapsed = millis() - previousMillis;                          //0 means the wait is over, and previousMillis becomes the new reference
+    if(elapsed > period) {
+        previousMillis = millis();
+        return 0;
+    }
+    return period - elapsed + 1;
+}
+
+unsigned int LCDControl::shiftText() {                                          //moves the tweet text to where it should be by now, returns the ms until the next column is due
+    //the position comes from the time since scrollStart, so a late call skips the columns it missed instead of showing them late
+    unsigned long now = millis();
+    unsigned int period = textSpeed + 1;                                        //ms per column, the old millis() check waited for more than textSpeed
+    unsigned int last = twtLength - LCDWIDTH;                                   //the end of the text fills the whole row
+    unsigned long due = scrollBase + (now - scrollStart) / period;
+    if(due > last) {
+        due = last;
     }
+    if(due != lcdPos) {
+        lcdPos = due;
+        //TweetHandler already converted the text for the lcd, so every step is just a LCDWIDTH window out of it
+        frameCursor(0, 1);                                                      //make sure we print on the bottom row
+        frameWrite(twt.getTweet(currentTweet) + lcdPos, LCDWIDTH);              //print the LCDWIDTH chars from the current position on
+        flush();                                                                //only the cells that changed get sent
+    }
+    if(lcdPos == last) {                                                        //at the end of the text, the read time counts from when it showed up
+        section++;
+        previousMillis = now;
+        return opt.getReadTime() + 1;
+    }
+    return scrollStart + (unsigned long)(lcdPos - scrollBase + 1) * period - now;
 }
 
 void LCDControl::setSpeed(int in) {                                             //used to set the text shifting speed
+    if(scroll && section == 1) {                                                //mid scroll: carry on from the current column, as far into its step as it got
+        unsigned long now = millis();
+        unsigned int period = textSpeed + 1;
+        unsigned long into = now - scrollStart - (unsigned long)(lcdPos - scrollBase) * period;
+        if(into > period) {                                                     //the next column is overdue already
+            into = period;
+        }
+        scrollBase = lcdPos;
+        scrollStart = now - into * (in + 1) / period;
+    }
     textSpeed = in;
 }
 
 //==============================================================================
 
 void LCDControl::CreateChar(byte code, PGM_P character) {                       //used to get custom characters out of progmem and into the lcd
-    byte* buffer = (byte*)malloc(8);
-    memcpy_P(buffer, character,  8);
-    lcdc.createChar(code, buffer);
-    free(buffer);
-}
-
-void LCDControl::bootAnim() {                                                   //simple boot animation, needs to be called after the custom chars are made
-    for(int i = 0; i <= 255; i++) {                                             //fades the backlight on
-        opt.setBrightness(i);
-        delay(2);
-    } 
-    //create each custom character for use
-    CreateChar(0, top1);
-    CreateChar(1, top2);
-    CreateChar(2, left1);
-    CreateChar(3, left2);
-    CreateChar(4, right2);
-    CreateChar(5, right1);
-
-    lcdc.clear();
-    lcdc.setCursor(0, 0);
-    lcdc.print(" ");
-    lcdc.print((char)0);
-    lcdc.print((char)1);
-    delay(250);
-    lcdc.setCursor(0, 1);
-    lcdc.print((char)2);
-    lcdc.print((char)3);
-    delay(250);
-    lcdc.print((char)4);
-    lcdc.print((char)5);
-    delay(250); 
-    lcdc.setCursor(6, 0);
-    lcdc.print("TwiScn");
-    lcdc.setCursor(6, 1);
-    lcdc.print("Version 1a"); 
-    delay(2000);
-    lcdc.setCursor(6, 0);
-    lcdc.print("Waiting   ");
-    lcdc.setCursor(6, 1);
-    lcdc.print("for USB   ");
+    for(byte i = 0; i < opCount; i++) {                                         //a load for this slot still waiting just gets the new char
+        LCDOp &op = ops[(opHead + i) % LCDQUEUE];
+        if(op.slot == code) {
+            op.data = character;
+            if(!i) {                                                            //it may be partly sent already
+                opProgress = 0;
+            }
+            return;
+        }
+    }
+    LCDOp &op = ops[(opHead + opCount) % LCDQUEUE];                             //one load per slot at most, so there's always room
+    op.slot = code;
+    op.data = character;                                                        //read straight out of progmem when it gets sent
+    opCount++;
+}
+
+//the 8 CGRAM slots work as a cache for the custom glyphs, so CreateChar only runs when a glyph isn't loaded already
+
+char LCDControl::glyphSlot(byte glyph) {                                        //returns the CGRAM slot holding glyph, loads it first if it isn't in one
+    byte i = 0;
+    while(i < CGRAMSLOTS && slotGlyph[slotOrder[i]] != glyph) {
+        i++;
+    }
+    if(i == CGRAMSLOTS) {                                                       //not loaded, take the least recently used slot that isn't on the frame
+        do {
+            if(!i) {                                                            //all 8 are in use on the lcd
+                return NOGLYPH;
+            }
+            i--;
+        } while(onFrame(slotOrder[i]));
+        slotGlyph[slotOrder[i]] = glyph;
+        CreateChar(slotOrder[i], glyphs[glyph]);
+    }
+    byte slot = slotOrder[i];
+    memmove(slotOrder + 1, slotOrder, i);                                       //now it's the most recently used
+    slotOrder[0] = slot;
+    return slot;
+}
+
+bool LCDControl::onFrame(char c) {                                              //true if any cell of the frame, or of the lcd until the frame is sent, holds c
+    for(byte r = 0; r < 2; r++) {
+        if(memchr(frame[r], c, LCDWIDTH) || memchr(shown[r], c, LCDWIDTH)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LCDControl::bootAnim() {                                                   //starts the boot animation, animate() plays it
+    startSequence(SEQBOOT, 0);
+}
+
+unsigned int LCDControl::bootStep() {                                           //draws the next part of the boot animation, returns the ms to show it for
+    switch(seqStep) {
+        case 0:
+            if(unsigned int fade = fadeTo(opt.getBootBrightness())) {           //fades the backlight on, then this step runs again
+                return fade;
+            }
+            frameClear();                                                       //the logo's custom chars get loaded as they're drawn
+            frameCursor(0, 0);
+            framePrint_P(PSTR(" "));
+            framePrint((char)(GLYPHFIRST + GLYPHLOGO));
+            framePrint((char)(GLYPHFIRST + GLYPHLOGO + 1));
+            flush();
+            seqStep++;
+            return 250;
+        case 1:
+            frameCursor(0, 1);
+            framePrint((char)(GLYPHFIRST + GLYPHLOGO + 2));
+            framePrint((char)(GLYPHFIRST + GLYPHLOGO + 3));
+            flush();
+            seqStep++;
+            return 250;
+        case 2:
+            framePrint((char)(GLYPHFIRST + GLYPHLOGO + 4));
+            framePrint((char)(GLYPHFIRST + GLYPHLOGO + 5));
+            flush();
+            seqStep++;
+            return 250;
+        case 3:
+            frameCursor(6, 0);
+            framePrint_P(PSTR("TwiScn"));
+            frameCursor(6, 1);
+            framePrint_P(PSTR("Version 1a")); 
+            flush();
+            seqStep++;
+            return 2000;
+    }
+    frameCursor(6, 0);
+    framePrint_P(PSTR("Waiting   "));
+    frameCursor(6, 1);
+    framePrint_P(PSTR("for USB   "));
+    flush();
+    sequence = SEQNONE;                                                         //all done
+    return IDLEPOLL;
 }
 
 void LCDControl::connectAnim() {                                                //displays a connecting animation on the lcd, must be called to advance "frames"
@@ -194,104 +423,181 @@ void LCDControl::connectAnim() {
     }
     switch(animCount) {
     case 0:
-        lcdc.setCursor(0, 1);
-        lcdc.print("    ");
-        lcdc.setCursor(1, 0);
-        lcdc.print((char)0);
-        lcdc.print((char)1);
+        frameCursor(0, 1);
+        framePrint_P(PSTR("    "));
+        frameCursor(1, 0);
+        framePrint((char)(GLYPHFIRST + GLYPHLOGO));
+        framePrint((char)(GLYPHFIRST + GLYPHLOGO + 1));
         break;
     case 1:
-        lcdc.setCursor(0, 0);
-        lcdc.print("   ");
-        lcdc.setCursor(0, 1);
-        lcdc.print((char)2);
-        lcdc.print((char)3);
+        frameCursor(0, 0);
+        framePrint_P(PSTR("   "));
+        frameCursor(0, 1);
+        framePrint((char)(GLYPHFIRST + GLYPHLOGO + 2));
+        framePrint((char)(GLYPHFIRST + GLYPHLOGO + 3));
         break;
     case 2:
-        lcdc.setCursor(0, 1);
-        lcdc.print("  ");
-        lcdc.print((char)4);
-        lcdc.print((char)5);
+        frameCursor(0, 1);
+        framePrint_P(PSTR("  "));
+        framePrint((char)(GLYPHFIRST + GLYPHLOGO + 4));
+        framePrint((char)(GLYPHFIRST + GLYPHLOGO + 5));
         break;
     }
+    flush();
 }
 
 void LCDControl::connectDisplay(bool connecting) {                              //displays a different message depending on if the device is connected or not
     if(connecting) {                                                            //if we are connecting, display the following message only once
         if(!ranOnce) {
-            lcdc.clear();
-            lcdc.setCursor(6, 0);
-            lcdc.print("Connecting");
-            lcdc.setCursor(6, 1);
-            lcdc.print("to Host");
+            frameClear();
+            frameCursor(6, 0);
+            framePrint_P(PSTR("Connecting"));
+            frameCursor(6, 1);
+            framePrint_P(PSTR("to Host"));
             ranOnce = true;                                                     //don't run this again
             animCount = 0;                                                      //reset the animCount in connectAnim
         }
     }
+    else if(twt.hasCurrent()) {                                                 //we still have a tweet, from before the host went away or from the EEPROM log
+        showTweet(!opt.getPrevTweet());
+        if(!opt.getScroll()) {                                                  //a warm reconnect keeps the scroll paused
+            scrollNotification(true);
+        }
+    }
     else {                                                                      //if we just finished connecting:
-        lcdc.clear();
-        lcdc.setCursor(0, 0);
-        lcdc.print("Waiting for");
-        lcdc.setCursor(0, 1);
-        lcdc.print("latest data...");
+        frameClear();
+        frameCursor(0, 0);
+        framePrint_P(PSTR("Waiting for"));
+        frameCursor(0, 1);
+        framePrint_P(PSTR("latest data..."));
     }
+    flush();
 }
 
-void LCDControl::disconnected() {
-    lcdc.clear();                                                           //display a warning message for 4 seconds
-    lcdc.setCursor(0, 0);
-    lcdc.print("Host has been");
-    lcdc.setCursor(0, 1);
-    lcdc.print("disconnected");
-    delay(4000);  
+void LCDControl::disconnected() {                                               //shows a disconnect notice for 4 seconds, then goes to sleep
+    setDisplay(true);                                                           //the lcd may have been sleeping
+    frameClear();
+    frameCursor(0, 0);
+    framePrint_P(PSTR("Host has been"));
+    frameCursor(0, 1);
+    framePrint_P(PSTR("disconnected"));
+    flush();
+    scroll = false;                                                             //no longer need to scroll
+    startSequence(SEQDISCONNECT, 4000);
 }
 
 void LCDControl::sleepLCD(bool sleep) {                                         //used to control lcd power state
     if(sleep) {                                                                 //if the lcd needs to go to sleep
-        lcdc.clear();                                                           //display a warning message for 4 seconds
-        lcdc.setCursor(0, 0);
-        lcdc.print("Going down for");
-        lcdc.setCursor(0, 1);
-        lcdc.print("standby...");
-        delay(2000);
+        frameClear();                                                           //display a warning message for 2 seconds
+        frameCursor(0, 0);
+        framePrint_P(PSTR("Going down for"));
+        frameCursor(0, 1);
+        framePrint_P(PSTR("standby..."));
+        flush();
         scroll = false;                                                         //no longer need to scroll
-        byte b = opt.getBrightness();                                           //get the current brightness to reference later
-        for(int i = b; i >= 0; i--) {                                           //fade out the backlight
-            opt.setBrightness(i);
-            delay(2);
-        }
-        lcdc.clear();                                                           //clear the display       
-        lcdc.noDisplay();                                                       //turn the lcd "off"
+        wakeBrightness = opt.getBrightness();                                   //remember the brightness to come back to
+        startSequence(SEQSLEEP, 2000);
     }
     else {                                                                      //lcd needs to wake up
-        lcdc.display();                                                         //turn the lcd "on" 
-        lcdc.clear();
+        setDisplay(true);                                                       //turn the lcd "on" 
+        frameClear();
         bootAnim();                                                             //play the boot animation
     }
 }
 
+unsigned int LCDControl::sleepStep() {                                          //fades out the backlight, then turns the lcd off
+    if(unsigned int fade = fadeTo(0)) {                                         //fades the backlight out, then this step runs again
+        return fade;
+    }
+    frameClear();                                                               //clear the display       
+    flush();
+    setDisplay(false);                                                          //turn the lcd "off"
+    sequence = SEQNONE;
+    return IDLEPOLL;
+}
+
 void LCDControl::wakeUp() {
-    lcdc.display();                                                         //turn the lcd "on" 
-    lcdc.clear();
+    setDisplay(true);                                                           //turn the lcd "on" 
+    frameClear();
     printNewTweet(true);
-    byte brightness = opt.getBrightness();
-    for(int i = 0; i <= brightness; i++) {                                             //fades the backlight on
-        opt.setBrightness(i);
-        delay(2);
-    } 
+    startSequence(SEQWAKE, 0);                                                  //fades the backlight on
+}
+
+void LCDControl::resume() {                                                     //the host came back before anything got reset: no boot animation, the lcd just comes back on
+    setDisplay(true);
+    frameClear();
+    flush();
+    wakeBrightness = opt.getBootBrightness();                                   //the disconnect notice and standby may have faded it, this is what the host asked for
+    startSequence(SEQWAKE, 0);                                                  //replaces the disconnect sequence, fades in while the handshake runs
+}
+
+//==============================================================================
+//the slow display sequences run a step at a time so nothing waits in delay() and usb keeps getting polled
+
+void LCDControl::startSequence(byte seq, unsigned int wait) {                   //replaces whatever sequence was running, first step runs after wait ms
+    sequence = seq;
+    seqStep = 0;
+    seqMillis = millis();
+    seqWait = wait;
+}
+
+unsigned int LCDControl::animate() {                                            //runs the next step of the display sequence once it's due, returns the ms until the step after
+    if(sequence == SEQNONE) {
+        return IDLEPOLL;
+    }
+    unsigned long elapsed = millis() - seqMillis;
+    if(elapsed < seqWait) {
+        return seqWait - elapsed;
+    }
+    seqMillis = millis();
+    switch(sequence) {
+        case SEQBOOT:
+            seqWait = bootStep();
+            break;
+        case SEQDISCONNECT:                                                     //the notice was up long enough
+            sleepLCD(true);
+            break;
+        case SEQSLEEP:
+            seqWait = sleepStep();
+            break;
+        case SEQWAKE:
+            seqWait = fadeTo(wakeBrightness);
+            if(!seqWait) {
+                sequence = SEQNONE;
+            }
+            break;
+    }
+    return sequence == SEQNONE ? IDLEPOLL : seqWait;
+}
+
+bool LCDControl::animating() {                                                  //true while the boot animation is still playing, the handshake waits for it
+    return sequence == SEQBOOT;
+}
+
+bool LCDControl::updating() {                                                   //true while lcd commands are still waiting for updateLCD()
+    return opCount || displayDue || frameDue;
+}
+
+unsigned int LCDControl::fadeTo(byte target) {                                  //starts fading the backlight to target, returns how long it takes, 0 if it's there already
+    byte b = opt.getBrightness();
+    unsigned int ms = (b < target ? target - b : b - target) * FADESTEP;
+    if(ms) {
+        opt.fadeBrightness(target, ms);                                         //the fader does the stepping from its interrupt
+    }
+    return ms;
 }
 
 void LCDControl::scrollNotification(boolean paused) {                           //used to display the "scrolling paused" notification, needs the scroll status
     if(paused) {                                                                //if scrolling was paused
         clearRow(0);                                                            //clear the top row
-        lcdc.print("[Scroll  Paused]");                                         //display the notice
+        framePrint_P(PSTR("[Scroll  Paused]"));                                 //display the notice
     }
     else {                                                                      //if scrolling was unpaused
-        if(twt.getUser() != "") {                                               //and also if we got the username
+        if(twt.getUserLength(true)) {                                           //and also if we got the username
             //needed when all options are set before the first tweet gets here
             clearRow(0);                                                        //clear the top row
-            lcdc.print(twt.getUser());                                          //print the username
+            frameWrite(twt.getUser(true), twt.getUserLength(true));             //print the username
         }
     }
-    
+    flush();
 }
\ No newline at end of file
@@ -6,14 +6,37 @@
 #include <LiquidCrystal.h>
 #include "Options.h"
 #include "TweetHandler.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+
+#define MAXWIDTH 20                                                             //widest display the frame buffer can hold
+#define NOCURSOR 0xFF                                                           //lcdRow value when the address counter position is unknown
+#define CGRAMSLOTS 8                                                            //custom chars the lcd holds at once
+#define LCDQUEUE CGRAMSLOTS                                                     //custom char loads waiting to be sent, never more than one per slot
+#define LCDBUDGET 4                                                             //bus transfers (about 265us each) sent per updateLCD() call
+#define EMPTYSLOT 0xFF                                                          //slotGlyph value of a slot nothing was loaded into
+//timed display sequences, stepped by animate()
+#define SEQNONE 0
+#define SEQBOOT 1                                                               //backlight fade in, logo and version
+#define SEQDISCONNECT 2                                                         //disconnect notice, then SEQSLEEP
+#define SEQSLEEP 3                                                              //standby notice, backlight fade out, lcd off
+#define SEQWAKE 4                                                               //backlight fade in to the brightness from before sleeping
+#define FADESTEP 2                                                              //ms per backlight brightness level while fading
+
+struct LCDOp {                                                                  //one queued custom char load
+    byte slot;
+    PGM_P data;
+};
 
 class LCDControl {
     public:
         LCDControl(int widthIn);
         void printNewTweet(bool current);
+        void showTweet(bool current);
+        void tweetQueued();
         void printUser();
         void printTweet();
-        void scrollTweet();
+        unsigned int scrollTweet();
         void sleepLCD(bool in);
         void prepareLCD();
         void connectAnim();
@@ -22,14 +45,35 @@ class LCDControl {
         void scrollNotification(boolean paused);
         void disconnected();
         void wakeUp();
+        void resume();
+        void updateLCD();
+        unsigned int animate();
+        bool animating();
+        bool updating();
         bool ranOnce;
     private:
         void CreateChar(byte code, PGM_P character);
+        char glyphSlot(byte glyph);
+        bool onFrame(char c);
         void clearRow(byte row);
-        void printBegin(String begin);
-        void shiftText();
+        void frameCursor(byte col, byte row);
+        void frameWrite(const char *text, unsigned int length);
+        void framePrint_P(PGM_P text);
+        void framePrint(char c);
+        void frameClear();
+        void flush();
+        bool sendFrame(byte &budget);
+        void setDisplay(bool on);
+        void drainLCD(byte budget);
+        void printBegin();
+        bool showNext();
+        unsigned int shiftText();
+        unsigned int waitFor(unsigned int period);
         void bootAnim();
-        String subTweet;
+        unsigned int bootStep();
+        unsigned int sleepStep();
+        unsigned int fadeTo(byte target);
+        void startSequence(byte seq, unsigned int wait);
         byte LCDWIDTH;    
         unsigned int textSpeed;
         bool printedBegin;
@@ -38,9 +82,31 @@ class LCDControl {
         bool currentTweet;
         byte animCount;
         byte section;     
-        byte lcdPos;
+        unsigned int lcdPos;
+        unsigned long scrollStart;                                              //when the text was at scrollBase, the position follows from the time since
+        unsigned int scrollBase;
         unsigned long previousMillis; 
-        int twtLength;
+        unsigned int twtLength;
+        char frame[2][MAXWIDTH];                                                //what the lcd should show
+        char shown[2][MAXWIDTH];                                                //what the lcd's DDRAM holds right now
+        byte frameCol;                                                          //write position in frame
+        byte frameRow;
+        byte lcdCol;                                                            //where the lcd's address counter points
+        byte lcdRow;
+        LCDOp ops[LCDQUEUE];                                                    //ring buffer of queued custom char loads
+        byte opHead;                                                            //index of the oldest queued load
+        byte opCount;
+        byte opProgress;                                                        //transfers already sent for the oldest load
+        bool displayDue;                                                        //displayOn hasn't been sent to the lcd yet
+        bool displayOn;
+        bool frameDue;                                                          //frame has changes the lcd hasn't got yet
+        byte sequence;                                                          //display sequence that's running, SEQNONE if there is none
+        byte seqStep;
+        unsigned long seqMillis;                                                //when the last step ran
+        unsigned int seqWait;                                                   //ms from seqMillis until the next step
+        byte wakeBrightness;                                                    //backlight brightness to fade back in to after sleeping
+        byte slotGlyph[CGRAMSLOTS];                                             //glyph id loaded into each CGRAM slot
+        byte slotOrder[CGRAMSLOTS];                                             //CGRAM slots, most recently used first
 };
 
 #endif	/* LCDCONTROL_H */
\ No newline at end of file
@@ -11,6 +11,8 @@ Options::Options() {
 
 void Options::defaults() {
     brightness = 0;                                                             //LCD backlight brightness
+    bootBrightness = 255;                                                       //what the boot animation fades the backlight in to
+    saveDue = false;
     setCol(0, 150, 255);                                                        //LCD backlight color
     setBlinkCol(255, 0, 0);                                                     //LCD backlight blink color
     rainbow = false;                                                            //rainbow LCD mode
@@ -22,6 +24,8 @@ void Options::defaults() {
     onPrevious = false;
     scroll = true;
     sleep = false;
+    aliveTime = 10;                                                             //hosts that don't know 'k' send a keepalive every few seconds
+    sofTimeout = 100;
 }
 
 //==============================================================================
@@ -30,6 +34,10 @@ byte Options::getBrightness() {
     return brightness;
 }
 
+byte Options::getBootBrightness() {
+    return bootBrightness;
+}
+
 byte *Options::getCol() {                                                       //returns a pointer to the color array
     return color;
 }
@@ -74,6 +82,14 @@ bool Options::getSleep() {
     return sleep;
 }
 
+unsigned long Options::getAliveTime() {                                         //in ms, 0 when keepalives aren't checked
+    return aliveTime * 1000UL;
+}
+
+byte Options::getSofTimeout() {
+    return sofTimeout;
+}
+
 //==============================================================================
 
 void Options::setBrightness(byte in) {
@@ -88,6 +104,18 @@ void Options::setCol(byte r, byte g, byte b) {
     inout.setBacklight(color[0], color[1], color[2], brightness);
 }
 
+void Options::fadeCol(byte r, byte g, byte b, unsigned long ms) {               //like setCol, but the backlight gets there over ms
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+    inout.fadeTo(color[0], color[1], color[2], brightness, ms);
+}
+
+void Options::fadeBrightness(byte in, unsigned long ms) {                       //like setBrightness, but the backlight gets there over ms
+    brightness = in;
+    inout.fadeTo(color[0], color[1], color[2], brightness, ms);
+}
+
 void Options::setBlinkCol(byte r, byte g, byte b) { 
     blinkColor[0] = r;
     blinkColor[1] = g;
@@ -128,99 +156,156 @@ void Options::updateBlinkCol() {
 
 //==============================================================================
 
-void Options::extractOption(String in) {                                        //used to extract the received option String from comms
-    char type = in.charAt(0);                                                   //get the first char out of the input, this is the option type
-    in = in.substring(1);                                                       //remove the the first character, it's no longer needed in there
-    switch(type) {                                                              //check that char
-        case 'b':                                                               //backlight brightness option
-            getBrightnessVal(in);                                               //extract the necessary data, and apply the new setting
+//options arrive in one of two forms after the '$':
+//  ascii:  a type letter then fixed width decimal fields, one option per transfer ("c000150255")
+//  binary: OPTBINARY then any number of records, each a type letter and a fixed size little endian payload,
+//          so a whole profile fits in one transfer. Comms has already undone the byte stuffing.
+
+void Options::extractOption(const char *in, unsigned int length) {              //applies the option transfer in (without the '$'), nothing gets copied
+    if(!length) {
+        return;
+    }
+    if((byte)in[0] == OPTBINARY) {
+        extractBinary((const byte *)in + 1, length - 1);
+        return;
+    }
+    char type = in[0];                                                          //first char is the option type
+    const char *f = in + 1;                                                     //the decimal fields after it
+    length--;
+    byte payload[OPTMAXPAYLOAD];                                                //the fields converted to the binary layout
+    unsigned int value;
+    switch(type) {
+        case 'b':                                                               //backlight brightness
+            payload[0] = field(f, length, 0, 3);
             break;
-        case 'c':                                                               //backlight color option           
-            getColorVal(in);                                                    //extract the necessary data, and apply the new setting   
+        case 'c':                                                               //backlight color, red green blue
+            for(byte i = 0; i < 3; i++) {
+                payload[i] = field(f, length, i * 3, i * 3 + 3);
+            }
             break;
-        case 'd':                                                               //tweet blink options, contains color, speed, and enable    
-            getTweetBlink(in);                                                  //extract the necessary data, and apply the new settings
+        case 'd':                                                               //tweet blink enable, speed and color
+            payload[0] = field(f, length, 0, 1);
+            payload[1] = field(f, length, 1, 4);
+            for(byte i = 0; i < 3; i++) {
+                payload[2 + i] = field(f, length, 4 + i * 3, 7 + i * 3);
+            }
             break;
-        case 'e':                                                               //rainbow mode option, contains speed and enable
-            getRainbow(in);                                                     //extract the necessary data, and apply the new settings
+        case 'e':                                                               //rainbow enable and speed
+            payload[0] = field(f, length, 0, 1);
+            value = field(f, length, 1, 6);
+            payload[1] = value & 0xFF;
+            payload[2] = value >> 8;
             break;
-        case 'f':                                                               //read time option, contains read time value
-            getReadTimeVal(in);                                                 //extract the necessary data, and apply the new settings
+        case 'f':                                                               //read time
+            value = field(f, length, 0, 5);
+            payload[0] = value & 0xFF;
+            payload[1] = value >> 8;
             break;
-        case 'g':                                                               //previous/current tweet option, just a toggle
-            getPrevTweet(in);                                                   //toggle the previous/current tweet
+        case 'k':                                                               //host loss timeouts, keepalive seconds then SOF ms, both stop at 255
+            for(byte i = 0; i < 2; i++) {
+                value = field(f, length, i * 3, i * 3 + 3);
+                payload[i] = value > 255 ? 255 : value;
+            }
             break;
-        case 'h':
-            getScrollVal(in);
+        default:                                                                //the rest are single digit toggles
+            payload[0] = field(f, length, 0, 1);
             break;
-        case 's':
-            getSleepVal(in);
-        default:
-            break;
-    } 
-}
-
-void Options::getBrightnessVal(String in) {                                     //used to get the brightness value out of a transfer, and apply it
-    String bright = in.substring(0, 3);                                         //get a substring containing the brightness value out
-    setBrightness((byte)bright.toInt());                                        //set the brightness to that value converted to a byte
+    }
+    applyOption(type, payload);
+    saveDue = true;                                                             //saveStep() writes it out once the host is done
+    changedAt = millis();
 }
 
-void Options::getColorVal(String in) {                                          //used to get the color value out of a transfer, and apply it
-    //get substrings of each color value out
-    String red = in.substring(0, 3);
-    String green = in.substring(3, 6);
-    String blue = in.substring(6, 9);
-    setCol((byte)red.toInt(), (byte)green.toInt(), (byte)blue.toInt());         //convert each value to a byte, and send it to get applied
+void Options::extractBinary(const byte *in, unsigned int length) {              //applies every record in a binary option transfer
+    while(length) {
+        byte size = payloadSize(in[0]);
+        if(!size || size >= length) {                                           //unknown type or a cut off record, can't trust anything after it
+            break;
+        }
+        applyOption(in[0], in + 1);
+        in += size + 1;
+        length -= size + 1;
+    }
+    saveDue = true;
+    changedAt = millis();
 }
 
-void Options::getTweetBlink(String in) {                                        //used to get the tweet blink values out of a transfer, and apply them  
-    String enable = in.substring(0, 1);                                         //first get the enable setting out
-    if(enable.toInt() == 0) {                                                   //check if the host enabled tweetblink, and then enable/disable 
-        setBlink(false);
-    }
-    else {
-        setBlink(true);
+byte Options::payloadSize(char type) {                                          //payload bytes that follow each option type in the binary format, 0 if unknown
+    switch(type) {
+        case 'b':
+        case 'g':
+        case 'h':
+        case 's':
+            return 1;
+        case 'c':
+        case 'e':
+            return 3;
+        case 'd':
+            return 5;
+        case 'f':
+        case 'k':
+            return 2;
     }
-    
-    String spd = in.substring(1, 4);                                            //get a substring containing the blink speed value out
-    setBlinkSpd((byte)spd.toInt());                                             //set the speed to that value converted to a byte
-    
-    //get the blink color values out in substrings
-    String red = in.substring(4, 7);
-    String green = in.substring(7, 10);
-    String blue = in.substring(10, 13);
-    setBlinkCol((byte)red.toInt(), (byte)green.toInt(), (byte)blue.toInt());    //convert each value to a byte, and send it to get applied
+    return 0;
 }
 
-void Options::getRainbow(String in) {                                           //used to get the rainbow settings out of a transfer, and apply them
-    String enable = in.substring(0, 1);                                         //first get the enable setting out
-    if(enable.toInt() == 0) {                                                   //check if the host enabled rainbow mode, and then enable/disable 
-        setRainbow(false);
+unsigned int Options::field(const char *in, unsigned int length, byte from, byte to) {  //reads the decimal digits in in[from, to), stops at the end of the transfer
+    unsigned int value = 0;
+    for(byte i = from; i < to && i < length && in[i] >= '0' && in[i] <= '9'; i++) {
+        value = value * 10 + (in[i] - '0');
     }
-    else {
-        setRainbow(true);
-    }
-    
-    String spd = in.substring(1, 6);                                            //get a substring containing the rainbow speed value out
-    setRainSpd(spd.toInt());                                                    //set the speed to that value converted to an int
+    return value;
 }
 
-void Options::getReadTimeVal(String in) {
-    String time = in.substring(0, 5);                                           //get a substring containing the read time value out
-    setReadTime(time.toInt());     
+void Options::applyOption(char type, const byte *payload) {                     //applies one option, payload is in the binary layout
+    switch(type) {
+        case 'b':                                                               //backlight brightness option
+            setBrightness(payload[0]);
+            bootBrightness = payload[0];
+            break;
+        case 'c':                                                               //backlight color option
+            setCol(payload[0], payload[1], payload[2]);
+            break;
+        case 'd':                                                               //tweet blink options, contains enable, speed, and color
+            setBlink(payload[0] != 0);
+            setBlinkSpd(payload[1]);
+            setBlinkCol(payload[2], payload[3], payload[4]);
+            break;
+        case 'e':                                                               //rainbow mode option, contains enable and speed
+            setRainbow(payload[0] != 0);
+            setRainSpd(payload[1] | (payload[2] << 8));
+            break;
+        case 'f':                                                               //read time option
+            setReadTime(payload[0] | (payload[1] << 8));
+            break;
+        case 'g':                                                               //previous/current tweet option
+            setPrevTweet(payload[0] != 0);
+            break;
+        case 'h':                                                               //scroll pause option
+            setScroll(payload[0] != 0);
+            break;
+        case 's':                                                               //sleep option
+            sleep = payload[0] != 0;
+            break;
+        case 'k':                                                               //host loss timeouts, not saved: a host that stops sending keepalives says so each time it connects
+            aliveTime = payload[0];
+            sofTimeout = payload[1];
+            break;
+        default:
+            break;
+    }
 }
 
-void Options::getPrevTweet(String in) {                                         //toggles the current/previous tweet
-    String enable = in.substring(0, 1);                                         //get the enable setting out
-    if(enable.toInt() == 0) {                                                   //if the previous tweet was disabled
-        if(getPrevTweet()) {                                                      //only set it to the current tweet if we are on the previous one already
+void Options::setPrevTweet(bool in) {                                           //switches between the current and previous tweet
+    if(!in) {                                                                   //if the previous tweet was disabled
+        if(getPrevTweet()) {                                                    //only set it to the current tweet if we are on the previous one already
             //set the tweet to the current one
             onPrevious = false;
             lcd.printNewTweet(true);
         }
     }
     else {                                                                      //if the previous tweet was enabled
-        if(twt.getPrevTweet() != "") {                                          //make sure there is a previous tweet first
+        if(twt.getTweetLength(false)) {                                         //make sure there is a previous tweet first
             if(!getPrevTweet()) {                                               //only set it to the previous tweet if we are on the current one already
                 //set the tweet to the previous one
                 onPrevious = true;
@@ -230,24 +315,77 @@ void Options::getPrevTweet(String in) {
     }
 }
 
-void Options::getScrollVal(String in) {                                         //gets the scroll value out from the incoming data transfer
-    String enable = in.substring(0, 1);                                         //get the enable setting out
-    if(enable.toInt() == 0) {                                                   //scrolling was paused
-        scroll = false;
-        lcd.scrollNotification(true);                                           //tell the lcd to display the scrolling paused notification
+void Options::setScroll(bool in) {                                              //pauses or resumes scrolling
+    scroll = in;
+    lcd.scrollNotification(!in);                                                //tell the lcd to display or remove the scrolling paused notification
+}
+
+//==============================================================================
+//saved options: load() runs before the boot animation, saveStep() runs as a task and only rewrites the bytes that changed
+
+bool Options::load() {                                                          //applies the saved options, false if there are none or they're damaged
+    byte record[OPTRECORD];
+    unsigned int crc = 0;
+    for(byte i = 0; i < OPTRECORD; i++) {
+        record[i] = EEPROM.read(OPTRECORDADDR + i);
+        if(i < OPTRECORD - 2) {
+            crc = _crc_xmodem_update(crc, record[i]);
+        }
     }
-    else {                                                                      //scrolling was resumed
-        scroll = true;
-        lcd.scrollNotification(false);                                          //tell the lcd to display the scrolling paused notification
+    if(record[0] != OPTVERSION || crc != ((unsigned int)record[OPTRECORD - 2] << 8 | record[OPTRECORD - 1])) {
+        return false;                                                           //never saved, an older layout, or a write cut off by a power loss
     }
+    bootBrightness = record[1];                                                 //brightness itself stays at 0, the boot animation fades it in
+    extractBinary(record + 2, OPTRECORD - 4);
+    saveDue = false;                                                            //that's what is saved already
+    return true;
 }
 
-void Options::getSleepVal(String in) {                                          //gets the sleep value out from the incoming data transfer
-    String enable = in.substring(0, 1);                                         //get the enable setting out
-    if(enable.toInt() == 0) {                                                   //sleep was disabled
-        sleep = false;
+unsigned int Options::saveStep() {                                              //writes one changed byte of the saved options, returns the ms until it's due again
+    if(!saveDue) {
+        return IDLEPOLL;
     }
-    else {                                                                      //sleep was enabled
-        sleep = true;
+    unsigned long quiet = millis() - changedAt;
+    if(quiet < OPTSAVEDELAY) {                                                  //more are probably on the way
+        return OPTSAVEDELAY - quiet;
     }
-}
\ No newline at end of file
+    byte record[OPTRECORD];
+    buildRecord(record);
+    for(byte i = 0; i < OPTRECORD; i++) {                                       //in order, so the crc is the last thing to change
+        if(EEPROM.read(OPTRECORDADDR + i) != record[i]) {                       //bytes that are already right don't wear the cell again
+            EEPROM.write(OPTRECORDADDR + i, record[i]);
+            return OPTWRITEGAP;
+        }
+    }
+    saveDue = false;                                                            //all of it matches now
+    return IDLEPOLL;
+}
+
+void Options::buildRecord(byte *record) {                                       //lays out the saved options, see OPTRECORD
+    record[0] = OPTVERSION;
+    record[1] = bootBrightness;
+    byte *r = record + 2;
+    *r++ = 'c';
+    for(byte i = 0; i < 3; i++) {                                               //while the rainbow runs color is just the section it's on, keep the saved one
+        *r++ = rainbow ? EEPROM.read(OPTRECORDADDR + 3 + i) : color[i];
+    }
+    *r++ = 'd';
+    *r++ = blink;
+    *r++ = blinkSpd;
+    for(byte i = 0; i < 3; i++) {
+        *r++ = blinkColor[i];
+    }
+    *r++ = 'e';
+    *r++ = rainbow;
+    *r++ = rainSpd & 0xFF;
+    *r++ = rainSpd >> 8;
+    *r++ = 'f';
+    *r++ = readTime & 0xFF;
+    *r++ = readTime >> 8;
+    unsigned int crc = 0;
+    for(byte i = 0; i < OPTRECORD - 2; i++) {
+        crc = _crc_xmodem_update(crc, record[i]);
+    }
+    record[OPTRECORD - 2] = crc >> 8;
+    record[OPTRECORD - 1] = crc & 0xFF;
+}
@@ -2,14 +2,27 @@
 #define	OPTIONS_H
 
 #include <Arduino.h>
+#include <EEPROM.h>
+#include <util/crc16.h>
 #include "IO.h"
 #include "LCDControl.h"
 #include "TweetHandler.h"
 
+#define OPTBINARY 0x81                                                          //second byte of a binary option transfer, high bit plus format version 1
+#define OPTMAXPAYLOAD 5                                                         //largest option payload in the binary format
+//the options the host set are kept in EEPROM so the next boot already looks right: a version byte, the boot
+//brightness, the 'c', 'd', 'e' and 'f' records in the binary format, then a crc16 of all that
+#define OPTRECORDADDR 0                                                         //EEPROM address of the saved options
+#define OPTVERSION 1                                                            //layout of the saved options, older ones get ignored
+#define OPTRECORD 21
+#define OPTSAVEDELAY 2000                                                       //ms without option changes before they get saved, a host sends them in bursts
+#define OPTWRITEGAP 4                                                           //ms between EEPROM byte writes, each takes 3.4ms and blocks the next one
+
 class Options {
     public:
         Options();   
         byte getBrightness();
+        byte getBootBrightness();
         byte *getCol();
         byte *getBlinkCol();
         byte getBlinkSpd();
@@ -21,9 +34,15 @@ class Options {
         bool getSleep();
         int getRainSpd();
         int getReadTime();
+        unsigned long getAliveTime();
+        byte getSofTimeout();
         void defaults();
+        bool load();
+        unsigned int saveStep();
         void setBrightness(byte in);
         void setCol(byte r, byte g, byte b);
+        void fadeCol(byte r, byte g, byte b, unsigned long ms);
+        void fadeBrightness(byte in, unsigned long ms);
         void setBlinkCol(byte r, byte g, byte b);
         void setRainbow(bool in);
         void setRainSpd(int in);
@@ -31,21 +50,23 @@ class Options {
         void setBlinkSpd(byte in);
         void setReadyBlink(bool in);
         void setReadTime(int in);
-        void extractOption(String in);
+        void extractOption(const char *in, unsigned int length);
         void updateCol();
         void updateBlinkCol();
     private:
-        void getBrightnessVal(String in);
-        void getColorVal(String in);
-        void getTweetBlink(String in);
-        void getRainbow(String in);
-        void getReadTimeVal(String in);
-        void getPrevTweet(String in);
-        void getScrollVal(String in);
-        void getSleepVal(String in);
+        void extractBinary(const byte *in, unsigned int length);
+        void applyOption(char type, const byte *payload);
+        byte payloadSize(char type);
+        unsigned int field(const char *in, unsigned int length, byte from, byte to);
+        void setPrevTweet(bool in);
+        void setScroll(bool in);
+        void buildRecord(byte *record);
         byte color[3];                                                    
         byte blinkColor[3]; 
         byte brightness;
+        byte bootBrightness;                                                    //brightness the host asked for, the lcd's own fades move brightness
+        bool saveDue;                                                           //options changed since they were last saved
+        unsigned long changedAt;
         byte blinkSpd;                                                         
         bool rainbow;
         bool blink;
@@ -55,6 +76,8 @@ class Options {
         bool sleep;
         unsigned int readTime;
         unsigned int rainSpd;                                                   
+        byte aliveTime;                                                         //s the host can go without a '%' keepalive, 0 if it doesn't send them
+        byte sofTimeout;                                                        //ms without a USB start of frame before the bus counts as gone, 0 to not watch it
 };
 
 #endif	/* OPTIONS_H */
@@ -0,0 +1,38 @@
+//timing table for the PROFILE() sections, see Profiler.h
+#include "Profiler.h"
+
+#ifdef PROFILING
+
+ProfStats profTable[PROFSECTIONS];
+
+const char profNames[PROFSECTIONS * PROFNAMEWIDTH + 1] PROGMEM =
+    "comms\0\0\0"
+    "scroll\0\0"
+    "rainbow\0"
+    "blink\0\0\0";
+
+void profRecord(byte section, unsigned long us) {                               //adds one call of us to a section
+    ProfStats &s = profTable[section];
+    s.calls++;
+    s.total += us;                                                              //the whole of it, only min and max are 16 bits
+    if(us > 0xFFFF) {
+        us = 0xFFFF;
+    }
+    if(s.calls == 1 || us < s.low) {
+        s.low = us;
+    }
+    if(us > s.high) {
+        s.high = us;
+    }
+}
+
+void profReset() {                                                              //starts every section over
+    for(byte i = 0; i < PROFSECTIONS; i++) {
+        profTable[i].calls = 0;
+        profTable[i].total = 0;
+        profTable[i].low = 0;
+        profTable[i].high = 0;
+    }
+}
+
+#endif
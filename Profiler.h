@@ -0,0 +1,54 @@
+#ifndef PROFILER_H
+#define	PROFILER_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+//section profiler: PROFILE(section) at the top of a function times everything up to its return and adds it to that
+//section's row of profTable. it's only there when PROFILING is defined (see the Makefile), otherwise PROFILE()
+//is nothing and the table and its code aren't built at all
+#define PROFCOMMS 0                                                             //Comms::readComms()
+#define PROFSCROLL 1                                                            //LCDControl::scrollTweet()
+#define PROFRAINBOW 2                                                           //IO::rainbow()
+#define PROFBLINK 3                                                             //IO::tweetBlink()
+#define PROFSECTIONS 4
+#define PROFNAMEWIDTH 8                                                         //chars per name in profNames, shorter ones are padded with zeros
+
+#ifdef PROFILING
+
+struct ProfStats {                                                              //one section's timing since the last profReset()
+    unsigned long calls;
+    unsigned long total;                                                        //us
+    unsigned int low;                                                           //shortest call in us
+    unsigned int high;                                                          //longest, calls over 65ms read as 65535
+};
+
+extern ProfStats profTable[PROFSECTIONS];
+extern const char profNames[] PROGMEM;                                          //PROFSECTIONS names of PROFNAMEWIDTH chars
+
+void profRecord(byte section, unsigned long us);
+void profReset();
+
+class ProfTimer {                                                               //times the scope it's declared in
+    public:
+        ProfTimer(byte sectionIn) {
+            section = sectionIn;
+            start = micros();
+        }
+        ~ProfTimer() {
+            profRecord(section, micros() - start);
+        }
+    private:
+        byte section;
+        unsigned long start;
+};
+
+#define PROFILE(section) ProfTimer profTimer(section)
+
+#else
+
+#define PROFILE(section)
+
+#endif
+
+#endif	/* PROFILER_H */
@@ -0,0 +1,94 @@
+//runs the periodic tasks only when they are due, instead of every task checking millis() on every loop
+
+#include "Scheduler.h"
+
+Scheduler::Scheduler() {
+    taskCount = 0;
+#ifdef PROFILING
+    resetStats();
+#endif
+}
+
+byte Scheduler::addTask(TaskFunc func, unsigned int delayMs) {                  //registers a task to first run in delayMs, returns its id or NOTASK if it's full
+    if(taskCount == MAXTASKS) {
+        return NOTASK;
+    }
+    Task &t = tasks[taskCount];
+    t.func = func;
+    t.nextRun = millis() + delayMs;
+#ifdef PROFILING
+    t.runs = 0;
+    t.totalMicros = 0;
+    t.maxMicros = 0;
+#endif
+    return taskCount++;
+}
+
+void Scheduler::runIn(byte id, unsigned int delayMs) {                          //moves a task's deadline, use 0 to run it on the next pass
+    if(id >= taskCount) {                                                       //NOTASK, the task never got registered
+        return;
+    }
+    tasks[id].nextRun = millis() + delayMs;
+}
+
+bool Scheduler::runDue() {                                                      //runs every task whose deadline passed, must be called continuously. false if none was due
+    bool ran = false;
+    for(byte i = 0; i < taskCount; i++) {
+        Task &t = tasks[i];
+        if((long)(millis() - t.nextRun) < 0) {                                  //not due yet (signed compare so millis() rollover is fine)
+            continue;
+        }
+#ifdef PROFILING
+        unsigned long start = micros();
+#endif
+        unsigned int next = t.func();
+#ifdef PROFILING
+        unsigned long took = micros() - start;
+        t.runs++;
+        t.totalMicros += took;
+        if(took > t.maxMicros) {
+            t.maxMicros = took;
+        }
+#endif
+        t.nextRun = millis() + next;                                            //count from when the task finished
+        ran = true;
+    }
+#ifdef PROFILING
+    passes++;
+    if(!ran) {
+        idlePasses++;
+    }
+#endif
+    return ran;
+}
+
+byte Scheduler::getTaskCount() {
+    return taskCount;
+}
+
+const Task &Scheduler::getTask(byte id) {
+    return tasks[id];
+}
+
+//==============================================================================
+#ifdef PROFILING
+
+void Scheduler::resetStats() {                                                  //clears the per-task timing stats and pass counts
+    for(byte i = 0; i < taskCount; i++) {
+        tasks[i].runs = 0;
+        tasks[i].totalMicros = 0;
+        tasks[i].maxMicros = 0;
+    }
+    passes = 0;
+    idlePasses = 0;
+}
+
+unsigned long Scheduler::getPasses() {
+    return passes;
+}
+
+unsigned long Scheduler::getIdlePasses() {
+    return idlePasses;
+}
+
+#endif
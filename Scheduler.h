@@ -0,0 +1,46 @@
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#include <Arduino.h>
+
+#define MAXTASKS 10                                                             //most tasks that can be registered
+#define NOTASK 0xFF                                                             //addTask() id when the table is full
+#define IDLEPOLL 20                                                             //ms between checks for tasks that have nothing to do right now
+
+typedef unsigned int (*TaskFunc)();                                             //a task does its work and returns the ms until it wants to run again
+
+//the timing stats are only kept when PROFILING is defined (see the Makefile), like the section profiler
+struct Task {                                                                   //one registered task and its timing stats
+    TaskFunc func;
+    unsigned long nextRun;                                                      //millis() the task is due at
+#ifdef PROFILING
+    unsigned long runs;
+    unsigned long totalMicros;                                                  //time spent inside the task
+    unsigned long maxMicros;                                                    //longest single run
+#endif
+};
+
+class Scheduler {
+    public:
+        Scheduler();
+        byte addTask(TaskFunc func, unsigned int delayMs);
+        void runIn(byte id, unsigned int delayMs);
+        bool runDue();
+        byte getTaskCount();
+        const Task &getTask(byte id);
+#ifdef PROFILING
+        void resetStats();
+        unsigned long getPasses();
+        unsigned long getIdlePasses();
+#endif
+    private:
+        Task tasks[MAXTASKS];
+        byte taskCount;
+#ifdef PROFILING
+        unsigned long passes;                                                   //runDue() calls
+        unsigned long idlePasses;                                               //runDue() calls where nothing was due
+#endif
+};
+
+#endif	/* SCHEDULER_H */
+
@@ -0,0 +1,23 @@
+//dictionary for packed tweet text, see TextPack.h
+//picked from common english letter groups and the bits of text nearly every tweet has (links, retweets),
+//the host program has to use the exact same table
+
+#include "TextPack.h"
+
+const char packDict[PACKENTRIES * PACKWIDTH + 1] PROGMEM =
+    " the" "the " "ing " "and " "tion" " to " " of " " in "
+    " is " "http" "s://" "t.co" ".com" "RT @" " you" "for "
+    "with" "that" "this" "have" "just" " are" " was" " be "
+    " we " " it " " not" " all" " new" "our " "ould" "ight"
+    "out " "ther" "here" "what" "ment" "ally" " on " " a \0"
+    "ed \0" "er \0" "es \0" "ng \0" "re \0" "in\0\0" "th\0\0" "he\0\0"
+    "an\0\0" "er\0\0" "on\0\0" "at\0\0" "en\0\0" "nd\0\0" "ti\0\0" "es\0\0"
+    "or\0\0" "te\0\0" "ed\0\0" "is\0\0" "it\0\0" "al\0\0" "ar\0\0" "st\0\0"
+    "to\0\0" "nt\0\0" "ng\0\0" "se\0\0" "ha\0\0" "as\0\0" "ou\0\0" "io\0\0"
+    "le\0\0" "ve\0\0" "co\0\0" "me\0\0" "de\0\0" "hi\0\0" "ri\0\0" "ro\0\0"
+    "ic\0\0" "ne\0\0" "ea\0\0" "ra\0\0" "ce\0\0" "li\0\0" "ch\0\0" "ll\0\0"
+    "be\0\0" "ma\0\0" "si\0\0" "om\0\0" "ur\0\0" "e \0\0" "s \0\0" "t \0\0"
+    "d \0\0" "y \0\0" "n \0\0" "r \0\0" "o \0\0" " t\0\0" " a\0\0" " s\0\0"
+    " w\0\0" " c\0\0" " i\0\0" " o\0\0" " b\0\0" " f\0\0" " m\0\0" " p\0\0"
+    " h\0\0" " d\0\0" " l\0\0" " g\0\0" ". \0\0" ", \0\0" "! \0\0" "? \0\0"
+    "wh\0\0" "ow\0\0" "no\0\0" "ay\0\0" "ke\0\0" "ee\0\0" "oo\0\0";
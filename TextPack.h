@@ -0,0 +1,18 @@
+#ifndef TEXTPACK_H
+#define	TEXTPACK_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+//packed tweet text: plain ascii bytes stand for themselves, a byte from PACKFIRST up
+//stands for a dictionary entry of common english/tweet letter groups, and PACKESCAPE
+//makes the next byte a literal (for utf-8 bytes that would read as codes).
+//there are never any zero bytes, so it survives HIDSerial as is
+#define PACKFIRST 0x80                                                          //code of the first dictionary entry
+#define PACKESCAPE 0xFF                                                         //next byte is a literal
+#define PACKWIDTH 4                                                             //chars per entry, shorter ones are padded with zeros
+#define PACKENTRIES (PACKESCAPE - PACKFIRST)
+
+extern const char packDict[] PROGMEM;                                           //PACKENTRIES entries of PACKWIDTH chars
+
+#endif	/* TEXTPACK_H */
@@ -1,84 +1,414 @@
 //used for storing and handling tweets
 
 #include "TweetHandler.h"
+#include "Options.h"
 
-TweetHandler::TweetHandler(int widthIn) {                                       //constructor, needs the LCDWIDTH   
+extern Options opt;
+
+//unicode characters the lcd can show, sorted by code point. the rest of the ascii range is shown as is,
+//some letters have a lookalike in the lcd's rom (A00, the japanese one), the common accented ones get a custom glyph,
+//and everything else becomes the plain letter, NOGLYPH, or nothing for the zero width ones
+static const CharMap charMap[] PROGMEM = {
+    {0x00A0, ' '}, {0x00A1, '!'}, {0x00A2, 0xEC}, {0x00A3, 0xED},
+    {0x00A5, 0x5C}, {0x00AB, '"'}, {0x00AD, 0}, {0x00B0, 0xDF},
+    {0x00B5, 0xE4}, {0x00B7, 0xA5}, {0x00BB, '"'}, {0x00BF, '?'},
+    {0x00C0, 'A'}, {0x00C1, 'A'}, {0x00C2, 'A'}, {0x00C3, 'A'},
+    {0x00C4, 'A'}, {0x00C5, 'A'}, {0x00C6, 'A'}, {0x00C7, 'C'},
+    {0x00C8, 'E'}, {0x00C9, 'E'}, {0x00CA, 'E'}, {0x00CB, 'E'},
+    {0x00CC, 'I'}, {0x00CD, 'I'}, {0x00CE, 'I'}, {0x00CF, 'I'},
+    {0x00D1, 'N'}, {0x00D2, 'O'}, {0x00D3, 'O'}, {0x00D4, 'O'},
+    {0x00D5, 'O'}, {0x00D6, 'O'}, {0x00D7, 'x'}, {0x00D8, 'O'},
+    {0x00D9, 'U'}, {0x00DA, 'U'}, {0x00DB, 'U'}, {0x00DC, 'U'},
+    {0x00DD, 'Y'}, {0x00DF, 0xE2}, {0x00E0, GLYPHFIRST + GLYPHAGRAVE}, {0x00E1, 'a'},
+    {0x00E2, 'a'}, {0x00E3, 'a'}, {0x00E4, 0xE1}, {0x00E5, 'a'},
+    {0x00E6, 'a'}, {0x00E7, GLYPHFIRST + GLYPHCCEDIL}, {0x00E8, GLYPHFIRST + GLYPHEGRAVE}, {0x00E9, GLYPHFIRST + GLYPHEACUTE},
+    {0x00EA, 'e'}, {0x00EB, 'e'}, {0x00EC, 'i'}, {0x00ED, 'i'},
+    {0x00EE, 'i'}, {0x00EF, 'i'}, {0x00F1, 0xEE}, {0x00F2, 'o'},
+    {0x00F3, 'o'}, {0x00F4, 'o'}, {0x00F5, 'o'}, {0x00F6, 0xEF},
+    {0x00F7, 0xFD}, {0x00F8, 'o'}, {0x00F9, 'u'}, {0x00FA, 'u'},
+    {0x00FB, 'u'}, {0x00FC, 0xF5}, {0x00FD, 'y'}, {0x00FF, 'y'},
+    {0x03A3, 0xF6}, {0x03A9, 0xF4}, {0x03B1, 0xE0}, {0x03B2, 0xE2},
+    {0x03B5, 0xE3}, {0x03B8, 0xF2}, {0x03BC, 0xE4}, {0x03C0, 0xF7},
+    {0x03C1, 0xE6}, {0x03C3, 0xE5}, {0x200B, 0}, {0x200C, 0},
+    {0x200D, 0}, {0x2010, '-'}, {0x2011, '-'}, {0x2012, '-'},
+    {0x2013, '-'}, {0x2014, '-'}, {0x2015, '-'}, {0x2018, '\''},
+    {0x2019, '\''}, {0x201A, '\''}, {0x201C, '"'}, {0x201D, '"'},
+    {0x201E, '"'}, {0x2022, 0xA5}, {0x2026, GLYPHFIRST + GLYPHELLIPSIS}, {0x20AC, GLYPHFIRST + GLYPHEURO},
+    {0x2190, 0x7F}, {0x2192, 0x7E}, {0x221A, 0xE8}, {0x221E, 0xF3},
+    {0x263A, GLYPHFIRST + GLYPHSMILE}, {0x2665, GLYPHFIRST + GLYPHHEART}, {0x2764, GLYPHFIRST + GLYPHHEART}, {0xFE0E, 0},
+    {0xFE0F, 0},
+};
+#define CHARMAPSIZE (sizeof(charMap) / sizeof(charMap[0]))
+
+TweetHandler::TweetHandler(int widthIn) {                                       //constructor, needs the LCDWIDTH
     LCDWIDTH = widthIn;
-    //set all Strings to empty
-    user = "";
-    prevUser = "";
-    tweet = "";
-    prevTweet = "";
+    first = 0;                                                                  //nothing kept yet
+    count = 0;
+    used = 0;
+    shown = 0;
+    logging = false;
+    logDue = false;
+    logAt = 0 - LOGEVERY;                                                       //so the first record doesn't have to wait
+    adding = false;
+    logNext = 0;                                                                //restore() picks up where the log left off
+    logSeq = 0;
 }
 
-void TweetHandler::setUser(String in) {                                         //sets the username
-    prevUser = user;                                                            //save a copy of the current (now previous) user
-    user = in;                                                                  //set the new user
-}
+//tweets are rendered into the free end of the pool as their bytes come in, so there is no full size buffer for them
+//anywhere else: beginTweet() starts one with its user, addText() takes the text a packet at a time and endTweet()
+//queues it or throws it away. the previous tweet only makes room for it once it's needed
 
-void TweetHandler::setTweet(String in) {                                        //sets the tweet text
-    prevTweet = tweet;                                                          //save a copy of the current (now previous) tweet
-    tweet = in;                                                                 //set the new tweet
+bool TweetHandler::beginTweet(const char *userIn, byte userLength) {            //starts a new tweet behind the ones waiting to be shown, false if the queue is full
+    adding = false;                                                             //a tweet still going never got finished, forget it
+    while(count == TWEETQUEUE) {
+        if(!makeRoom()) {
+            return false;
+        }
+    }
+    adding = true;
+    addFull = false;
+    addLen = 0;
+    addUserLen = 0;
+    addMore = 0;
+    addText(userIn, userLength > USERSIZE ? USERSIZE : userLength);
+    if(addMore) {                                                               //a cut off sequence at the end of the user
+        addChar(lcdChar(0xFFFD));
+        addMore = 0;
+    }
+    addUserLen = addLen;
+    if(used + addLen == TWEETPOOL && !makeRoom()) {
+        addFull = true;
+    }
+    if(!addFull) {
+        pool[used + addLen++] = '\0';
+    }
+    return true;
 }
 
-//==============================================================================
+void TweetHandler::addText(const char *in, unsigned int length) {               //converts more utf-8 onto the tweet being added, a character can be split between calls
+    for(unsigned int i = 0; i < length && adding; i++) {
+        byte c = in[i];
+        if(addMore) {
+            if((c & 0xC0) == 0x80) {                                            //continuation byte
+                addCode = (addCode << 6) | (c & 0x3F);
+                if(!--addMore) {
+                    addChar(lcdChar(addCode));
+                }
+                continue;
+            }
+            addMore = 0;                                                        //cut off sequence, c starts the next character
+            addChar(lcdChar(0xFFFD));
+        }
+        if(c >= 0xF0) {                                                         //lead bytes, the continuation bytes follow
+            addCode = c & 0x07;
+            addMore = 3;
+        }
+        else if(c >= 0xE0) {
+            addCode = c & 0x0F;
+            addMore = 2;
+        }
+        else if(c >= 0xC0) {
+            addCode = c & 0x1F;
+            addMore = 1;
+        }
+        else {
+            addChar(lcdChar(c >= 0x80 ? 0xFFFD : c));                           //ascii, or a stray continuation byte
+        }
+    }
+}
 
-String TweetHandler::getUser() {
-    return user;
+void TweetHandler::addChar(byte c) {                                            //appends one lcd char to the tweet being added, at most one per character
+    if(!c || addFull || addLen >= addUserLen + 1u + TWEETSIZE) {                //while the user goes in addUserLen is 0, and it's never that long
+        return;
+    }
+    if(used + addLen == TWEETPOOL && !makeRoom()) {                             //the pool is full and nothing can go
+        addFull = true;
+        return;
+    }
+    pool[used + addLen++] = c;
 }
 
-String TweetHandler::getTweet() {
-    return tweet;
+bool TweetHandler::endTweet(bool keep) {                                        //queues the tweet being added, false if it wasn't kept or didn't fit
+    if(!adding) {
+        return false;
+    }
+    if(keep && addMore) {
+        addChar(lcdChar(0xFFFD));
+    }
+    TweetEntry &e = at(count);
+    e.userLen = addUserLen;
+    e.textLen = addLen - addUserLen - 1;
+    while(keep && !addFull && used + size(e) > TWEETPOOL) {                     //short tweets get padded, that needs room too
+        if(!makeRoom()) {
+            addFull = true;
+        }
+    }
+    adding = false;
+    if(!keep || addFull) {
+        return false;
+    }
+    e.offset = used;
+    char *text = pool + used + e.userLen + 1;
+    unsigned int padded = e.textLen;
+    while(padded < LCDWIDTH) {                                                  //short tweets always fill the bottom row
+        text[padded++] = ' ';
+    }
+    text[padded] = '\0';
+    used += size(e);
+    count++;
+    return true;
 }
 
-int TweetHandler::getTweetLength() {
-    return tweet.length();
+bool TweetHandler::makeRoom() {                                                 //drops the oldest tweet if it's the previous one and it isn't on the lcd
+    if(shown < 2 || opt.getPrevTweet()) {
+        return false;
+    }
+    dropOldest();
+    return true;
 }
 
-int TweetHandler::getPrevLength() {
-    return prevTweet.length();
+byte TweetHandler::lcdChar(unsigned long code) {                                //what the lcd shows for a unicode character, 0 if it takes no space
+    if(code < 0x80) {
+        if(code < ' ' || code == 0x7F) {                                        //line breaks, tabs and other control chars, chars 0-7 would be custom chars
+            return ' ';
+        }
+        if(code == '\\') {
+            return GLYPHFIRST + GLYPHBACKSLASH;
+        }
+        if(code == '~') {
+            return GLYPHFIRST + GLYPHTILDE;
+        }
+        return code;
+    }
+    if(code >= 0x1F600 && code <= 0x1F64F) {                                    //the emoticon faces all get the one smiley
+        return GLYPHFIRST + GLYPHSMILE;
+    }
+    if(code >= 0x1F3FB && code <= 0x1F3FF) {                                    //skin tone modifiers
+        return 0;
+    }
+    if(code > 0xFFFF) {
+        return NOGLYPH;
+    }
+    unsigned int low = 0;                                                       //binary search, the table is sorted
+    unsigned int high = CHARMAPSIZE;
+    while(low < high) {
+        unsigned int mid = (low + high) / 2;
+        uint16_t midCode = pgm_read_word(&charMap[mid].code);
+        if(midCode == code) {
+            return pgm_read_byte(&charMap[mid].lcd);
+        }
+        if(midCode < code) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return NOGLYPH;
 }
 
-String TweetHandler::getPrevUser() {
-    return prevUser;
+unsigned int TweetHandler::size(TweetEntry &e) {                                //pool bytes a kept tweet takes up
+    return e.userLen + (e.textLen > LCDWIDTH ? e.textLen : LCDWIDTH) + 2;
 }
 
-String TweetHandler::getPrevTweet() {
-    return prevTweet;
+void TweetHandler::dropOldest() {                                               //forgets the oldest tweet and slides the rest down to the start of the pool
+    if(logging && logSlot == first) {                                           //its log record won't get finished, the next one goes in the same place
+        logging = false;
+    }
+    unsigned int gone = size(at(0));
+    memmove(pool, pool + gone, used + (adding ? addLen : 0) - gone);            //the getters hand out fresh pointers every call, so moving is fine, a tweet being added moves along
+    used -= gone;
+    first = (first + 1) % TWEETQUEUE;
+    count--;
+    shown--;
+    for(byte i = 0; i < count; i++) {
+        at(i).offset -= gone;
+    }
 }
 
-String TweetHandler::getTweetBegin() {                                          //returns the beginning of the tweet
-    if(tweet.length() <= LCDWIDTH) {                                            //check if the tweet is less than LCDWIDTH first
-        return tweet;                                                           //no need to shorten, just return the unchanged tweet
-    } 
-    else {                                                                      //needs to be shortened, longer than LCDWIDTH
-        beginning = tweet.substring(0, LCDWIDTH);                               //create a substring containing the first LCDWIDTH characters                                  
-        return beginning;
+bool TweetHandler::nextTweet() {                                                //makes the oldest queued tweet the current one, false if none are waiting
+    if(shown == count) {
+        return false;
+    }
+    shown++;
+    if(shown > 2) {                                                             //anything older than the previous tweet is no longer needed
+        dropOldest();
     }
+    logDue = true;                                                              //logStep() appends it to the EEPROM log once LOGEVERY allows
+    return true;
+}
+
+bool TweetHandler::hasCurrent() {
+    return shown > 0;
 }
 
-String TweetHandler::getPrevBegin() {                                           //returns the beginning of the previous tweet
-    if(prevTweet.length() <= LCDWIDTH) {                                        //check if the tweet is less than LCDWIDTH first
-        return tweet;                                                           //no need to shorten, just return the unchanged tweet
-    } 
-    else {                                                                      //needs to be shortened, longer than LCDWIDTH
-        beginning = prevTweet.substring(0, LCDWIDTH);                           //create a substring containing the first LCDWIDTH characters                                  
-        return beginning;
+byte TweetHandler::getPending() {                                               //tweets waiting for their turn on the lcd
+    return count - shown;
+}
+
+TweetEntry &TweetHandler::at(byte i) {                                          //i-th kept tweet, 0 is the oldest
+    return entries[(first + i) % TWEETQUEUE];
+}
+
+TweetEntry *TweetHandler::entry(bool current) {                                 //entry of the current or previous tweet, NULL if there is none
+    byte needed = current ? 1 : 2;
+    if(shown < needed) {
+        return NULL;
     }
+    return &at(shown - needed);
+}
+
+//==============================================================================
+//the getters hand out views into the pool, nothing gets copied
+//getTweet() always has at least LCDWIDTH chars, getTweetLength() doesn't count the padding
+
+const char *TweetHandler::getUser(bool current) {
+    TweetEntry *e = entry(current);
+    return e ? pool + e->offset : "";
+}
+
+byte TweetHandler::getUserLength(bool current) {
+    TweetEntry *e = entry(current);
+    return e ? e->userLen : 0;
+}
+
+const char *TweetHandler::getTweet(bool current) {
+    TweetEntry *e = entry(current);
+    return e ? pool + e->offset + e->userLen + 1 : "";
+}
+
+unsigned int TweetHandler::getTweetLength(bool current) {
+    TweetEntry *e = entry(current);
+    return e ? e->textLen : 0;
 }
 
 //==============================================================================
 
 bool TweetHandler::useScroll(bool current) {                                    //returns if tweet scrolling is necessary (longer than LCDWIDTH)
-    if(current) {
-        if(tweet.length() <= LCDWIDTH) {
-            return false;
+    return getTweetLength(current) > LCDWIDTH;
+}
+
+//==============================================================================
+//EEPROM tweet log: records are only ever appended, see LOGADDR
+
+void TweetHandler::restore() {                                                  //puts the newest logged tweet back up as the current one, only at boot before any tweet came in
+    bool found = false;
+    unsigned int best = 0;
+    unsigned int bestSeq = 0;
+    for(unsigned int a = 0; a < LOGSIZE; a++) {                                 //records can start anywhere, so look everywhere
+        if(logRead(a) != LOGMAGIC) {
+            continue;
+        }
+        byte userLen = logRead(a + 3);
+        unsigned int textLen = logRead(a + 4) | (logRead(a + 5) << 8);
+        if(userLen > USERSIZE || textLen > TWEETSIZE) {                         //just a byte that looks like the magic
+            continue;
+        }
+        unsigned int length = LOGHEADER + userLen + textLen;
+        unsigned int crc = 0;
+        for(unsigned int i = 0; i < length; i++) {
+            crc = _crc_xmodem_update(crc, logRead(a + i));
+        }
+        unsigned int saved = (logRead(a + length) << 8) | logRead(a + length + 1);
+        if(crc != saved) {                                                      //overwritten by newer records, or cut off by a power loss
+            continue;
+        }
+        unsigned int seq = logRead(a + 1) | (logRead(a + 2) << 8);
+        if(!found || (int16_t)(seq - bestSeq) > 0) {                            //the sequence number wraps, so compare the difference
+            found = true;
+            best = a;
+            bestSeq = seq;
         }
     }
-    else {
-        if(prevTweet.length() <= LCDWIDTH) {
-            return false;
+    if(!found) {
+        return;
+    }
+    byte userLen = logRead(best + 3);
+    unsigned int textLen = logRead(best + 4) | (logRead(best + 5) << 8);
+    TweetEntry &e = at(0);
+    e.offset = 0;
+    e.userLen = userLen;
+    e.textLen = textLen;
+    for(byte i = 0; i < userLen; i++) {                                         //it was logged the way the lcd shows it, nothing to render
+        pool[i] = logRead(best + LOGHEADER + i);
+    }
+    pool[userLen] = '\0';
+    char *text = pool + userLen + 1;
+    for(unsigned int i = 0; i < textLen; i++) {
+        text[i] = logRead(best + LOGHEADER + userLen + i);
+    }
+    unsigned int padded = textLen;
+    while(padded < LCDWIDTH) {
+        text[padded++] = ' ';
+    }
+    text[padded] = '\0';
+    used = size(e);
+    count = 1;
+    shown = 1;                                                                  //it's the current tweet, and it's in the log already
+    logNext = (best + LOGHEADER + userLen + textLen + 2) % LOGSIZE;
+    logSeq = bestSeq + 1;
+}
+
+unsigned int TweetHandler::logStep() {                                          //writes the next byte of the log record being made, runs as a task and returns the ms until it's due again
+    if(!logging) {
+        if(!logDue || millis() - logAt < LOGEVERY) {
+            return IDLEPOLL;
         }
+        logging = true;                                                         //start a record for the current tweet
+        logDue = false;
+        logAt = millis();
+        logSlot = (first + shown - 1) % TWEETQUEUE;
+        logAddr = logNext;
+        logPos = 0;
+        logCrc = 0;
+    }
+    TweetEntry &e = entries[logSlot];
+    unsigned int length = LOGHEADER + e.userLen + e.textLen;
+    byte b;
+    if(logPos < length) {
+        b = logByte(e, logPos);
+        logCrc = _crc_xmodem_update(logCrc, b);
     }
-    return true; 
-}
\ No newline at end of file
+    else {                                                                      //the crc goes last, until it's there the record doesn't count
+        b = logPos == length ? logCrc >> 8 : logCrc & 0xFF;
+    }
+    unsigned int address = LOGADDR + (logAddr + logPos) % LOGSIZE;
+    bool wrote = false;
+    if(EEPROM.read(address) != b) {                                             //a byte that's already right doesn't wear the cell again
+        EEPROM.write(address, b);
+        wrote = true;
+    }
+    logPos++;
+    if(logPos == length + 2) {
+        logging = false;
+        logNext = (logAddr + logPos) % LOGSIZE;
+        logSeq++;
+    }
+    return wrote ? LOGWRITEGAP : 0;
+}
+
+byte TweetHandler::logByte(TweetEntry &e, unsigned int i) {                     //i-th byte of the log record for e, without the crc
+    switch(i) {
+        case 0:
+            return LOGMAGIC;
+        case 1:
+            return logSeq & 0xFF;
+        case 2:
+            return logSeq >> 8;
+        case 3:
+            return e.userLen;
+        case 4:
+            return e.textLen & 0xFF;
+        case 5:
+            return e.textLen >> 8;
+    }
+    i -= LOGHEADER;
+    if(i < e.userLen) {
+        return pool[e.offset + i];
+    }
+    return pool[e.offset + e.userLen + 1 + i - e.userLen];                      //the text, skipping the user's terminator
+}
+
+byte TweetHandler::logRead(unsigned int at) {                                   //a log byte, at wraps around the end of the log
+    return EEPROM.read(LOGADDR + at % LOGSIZE);
+}
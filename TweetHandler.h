@@ -2,28 +2,101 @@
 #define	TWEETHANDLER_H
 
 #include <Arduino.h>
+#include <avr/pgmspace.h>
+#include <EEPROM.h>
+#include <util/crc16.h>
+
+#define TWEETSIZE 280                                                           //longest tweet text we keep
+#define USERSIZE 16                                                             //longest username we keep, only LCDWIDTH chars are ever shown
+#define TWEETQUEUE 8                                                            //most tweets kept at once: previous, current and the queued ones
+#define TWEETPOOL 896                                                           //bytes shared by all kept tweets, the queued ones and the one coming in
+#define NOGLYPH '?'                                                             //shown for characters the lcd has no glyph for
+//the tweet on the lcd gets appended to a ring shaped log in the rest of the EEPROM, so the writes go round all of it
+//evenly. a record is LOGMAGIC, a sequence number, the user and text lengths, the user and text as the lcd shows them,
+//then a crc16 of all that. the newest record that checks out is the tweet we come back up with. there's a record
+//every LOGEVERY at most, so with tweets coming in around the clock the 100k writes the cells are rated for last
+//about 10 years (TweetLogBench), 6 if every tweet is 280 chars. logging every tweet shown wore it out in one
+#define LOGADDR 32                                                              //EEPROM address of the tweet log, the saved options come before it
+#define LOGSIZE (E2END + 1 - LOGADDR)
+#define LOGMAGIC 0xA5
+#define LOGHEADER 6                                                             //magic, sequence (2), user length, text length (2)
+#define LOGWRITEGAP 4                                                           //ms between EEPROM byte writes, each takes 3.4ms and blocks the next one
+#define LOGEVERY 600000UL                                                       //ms from one record to the next at least, the tweets shown meanwhile aren't logged
+//custom glyphs are kept as GLYPHFIRST + glyph id (0x10-0x1F are blank in the lcd's rom, so nothing else uses them),
+//LCDControl swaps them for whichever CGRAM slot holds the glyph when it draws them
+#define GLYPHFIRST 0x10
+#define GLYPHCOUNT 16
+#define GLYPHLOGO 0                                                             //ids 0-5 are the boot logo
+#define GLYPHBACKSLASH 6                                                        //the rom has a yen sign at '\\' and an arrow at '~'
+#define GLYPHTILDE 7
+#define GLYPHEACUTE 8
+#define GLYPHEGRAVE 9
+#define GLYPHAGRAVE 10
+#define GLYPHCCEDIL 11
+#define GLYPHEURO 12
+#define GLYPHELLIPSIS 13
+#define GLYPHHEART 14
+#define GLYPHSMILE 15
+
+struct CharMap {                                                                //one unicode character the lcd can show, see charMap in TweetHandler.cpp
+    uint16_t code;
+    byte lcd;                                                                   //rom char or GLYPHFIRST + glyph id, 0 for characters that take no space
+};
+
+struct TweetEntry {                                                             //where one kept tweet lives in the pool
+    unsigned int offset;                                                        //user then text follow here, both null terminated and already in the lcd's encoding
+    byte userLen;
+    unsigned int textLen;                                                       //without the padding, the text is padded with spaces to at least LCDWIDTH
+};
 
 class TweetHandler {
     public:
         TweetHandler(int widthIn);
-        void setUser(String in);
-        void setTweet(String in);     
-        int getTweetLength();
-        int getPrevLength();
-        String getTweetBegin();
-        String getPrevBegin();
-        String getPrevUser();
-        String getPrevTweet();
-        String getUser();
-        String getTweet();
+        bool beginTweet(const char *userIn, byte userLength);
+        void addText(const char *in, unsigned int length);
+        bool endTweet(bool keep);
+        bool nextTweet();
+        bool hasCurrent();
+        byte getPending();
+        const char *getUser(bool current);
+        byte getUserLength(bool current);
+        const char *getTweet(bool current);
+        unsigned int getTweetLength(bool current);
         bool useScroll(bool current);
+        void restore();
+        unsigned int logStep();
     private:
+        TweetEntry *entry(bool current);
+        TweetEntry &at(byte i);
+        void dropOldest();
+        unsigned int size(TweetEntry &e);
+        void addChar(byte c);
+        bool makeRoom();
+        byte lcdChar(unsigned long code);
+        byte logByte(TweetEntry &e, unsigned int i);
+        byte logRead(unsigned int at);
         byte LCDWIDTH;
-        String user;
-        String tweet;
-        String prevUser;
-        String prevTweet;
-        String beginning;
+        char pool[TWEETPOOL];                                                   //tweets packed back to back from the start, oldest first
+        unsigned int used;                                                      //bytes of pool in use
+        TweetEntry entries[TWEETQUEUE];                                         //ring of kept tweets, oldest first
+        byte first;                                                             //index of the oldest entry in entries
+        byte count;                                                             //entries in use
+        byte shown;                                                             //entries that have been put on the lcd, the last of them is the current tweet
+        bool adding;                                                            //a tweet is being rendered in after the used part of the pool
+        bool addFull;                                                           //it ran out of pool, endTweet() will refuse it
+        unsigned int addLen;                                                    //bytes of it so far, user and terminator included
+        byte addUserLen;
+        unsigned long addCode;                                                  //utf-8 character being put together
+        byte addMore;                                                           //continuation bytes it still needs
+        bool logging;                                                           //a log record is being written
+        bool logDue;                                                            //the current tweet isn't in the log yet
+        unsigned long logAt;                                                    //millis() the last record was started
+        byte logSlot;                                                           //entries index of the tweet it's for
+        unsigned int logAddr;                                                   //where in the log the record starts
+        unsigned int logPos;                                                    //record bytes written so far
+        unsigned int logCrc;
+        unsigned int logNext;                                                   //where the next record goes
+        unsigned int logSeq;                                                    //sequence number of the next record
 };
 
 #endif	/* TWEETHANDLER_H */
@@ -3,6 +3,7 @@
 #include <Arduino.h>                                                            //used for its nice methods and stuff
 #include "usbdrv.h"                                                             //needed for SOF counts
 #include <avr/wdt.h>                                                            //needed to keep the whole system alive when USB is disconnected
+#include <avr/sleep.h>                                                          //idles the cpu between interrupts
 #include <LiquidCrystal.h>                                                      //used to control the LCD
 
 //included class headers: 
@@ -11,6 +12,11 @@
 #include "LCDControl.h"
 #include "Options.h"
 #include "TweetHandler.h"
+#include "Scheduler.h"
+
+//the bus going away is spotted from V-USB's start of frame counter. that needs USB_COUNT_SOF set to 1 in the HIDSerial
+//library's usbconfig.h and V-USB's interrupt wired to D-, it only sees start of frames there. without it checkAlive()
+//only watches keepalives, as if the 'k' start of frame timeout was 0
 
 //prototype declaration
 
@@ -18,17 +24,38 @@ void setup();
 void loop();
 void checkConnection();
 void deadSleep();
-void checkAlive();
+unsigned int checkAlive();
+void hostDied();
 void prepare();
+void reconnect();
 void checkSleep();
+unsigned int buttonsTask();
+unsigned int potTask();
+unsigned int rainbowTask();
+unsigned int scrollTask();
+unsigned int blinkTask();
+unsigned int sleepTask();
+unsigned int animTask();
+unsigned int saveTask();
+unsigned int logTask();
 
 //global variables, shouldn't hurt anything
 bool deadHost = false;                                                          //stores the dead host status
 bool sleeping = false;                                                          //stores the sleep status    
-const unsigned int ALIVEDELAY = 10000;                                           //max time to wait in between keepAlive updates
-unsigned long previousAlive = 0;                                                //last time an SOF happened in ms
-unsigned long previousMillis2 = 0;                                              //used for keeping track of SOF checking times
+unsigned long previousAlive = 0;                                                //keepAlive count at the last check
+unsigned long previousMillis2 = 0;                                              //used for keeping track of keepAlive checking times
+byte previousSof = 0;                                                           //usbSofCount at the last check, it's 8 bits so it wraps every 256ms
+unsigned long lastSof = 0;                                                      //last time usbSofCount moved in ms
 const int LCDWIDTH = 16;                                                        //character width of the LCD
+const unsigned int BUTTONPERIOD = 5;                                            //ms between button checks, the edges are timestamped so this only adds report latency
+const unsigned int POTPERIOD = 50;                                              //ms between looks at the filtered speed pot
+const unsigned int SLEEPPERIOD = 50;                                            //ms between sleep option checks
+const unsigned int DEADPOLL = 10;                                               //ms between keepAlive checks while the host is dead
+const unsigned int SOFPOLL = 20;                                                //ms between usbSofCount checks, has to stay well under the 256ms it takes to wrap
+const unsigned long COLDAFTER = 600000;                                         //ms the host can be gone and still get a warm reconnect, after that it's a fresh start
+unsigned long deadSince = 0;                                                    //millis() the host was found dead
+int lastSpeed = -1;                                                             //last speed pot value given to the lcd
+byte scrollId;                                                                  //scheduler id of the scroll task, the pot task reschedules it
     
 //global class initialization
 IO inout;                                                                       //new instance of IO
@@ -37,78 +64,183 @@ Options opt;
 TweetHandler twt(LCDWIDTH);                                                     //new instance of TweetHandler, needs the LCDWIDTH
 LCDControl lcd(LCDWIDTH);                                                       //new instance of LCDControl, needs the LCDWIDTH
 Comms comms;                                                                    //new instance of comms
+Scheduler sched;                                                                //runs the periodic tasks when they are due
 
 //==============================================================================
 
 void setup() {  
+    set_sleep_mode(SLEEP_MODE_IDLE);                                            //the deeper modes stop the clock V-USB needs to catch a packet
+    twt.restore();                                                              //the last tweet from the EEPROM log, it shows as soon as the host is there
     prepare();                                                                  //prepare the device for operation
+    //register the periodic tasks, each one returns how long until it wants to run again
+    sched.addTask(animTask, 0);
+    sched.addTask(buttonsTask, 0);
+    sched.addTask(potTask, 0);
+    sched.addTask(rainbowTask, 0);
+    scrollId = sched.addTask(scrollTask, 0);
+    sched.addTask(blinkTask, 0);
+    sched.addTask(checkAlive, SOFPOLL);
+    sched.addTask(sleepTask, 0);
+    sched.addTask(saveTask, 0);
+    sched.addTask(logTask, 0);
 }
 
 void loop() {
-    comms.readComms();                                                          //checks for any new comms data and processes it
-    inout.checkButtons();                                                       //monitors button changes and processes them
-    lcd.setSpeed(inout.checkPot());                                             //applies any changes made to the speed pot
-    inout.rainbow();                                                            //control the rainbow backlight changes                                                        
-    lcd.scrollTweet();                                                          //scrolls the tweet
-    inout.tweetBlink();                                                         //blinks the lcd if any new tweets are displayed
-    checkAlive();                                                               //checks if the device needs to be sleeping
+    bool busy = comms.readComms();                                              //checks for any new comms data and processes it
+    lcd.updateLCD();                                                            //sends a bounded slice of the queued lcd output
+    busy |= sched.runDue();                                                     //runs whichever tasks are due, nothing else gets touched
+    comms.loopDone();                                                           //telemetry, the time asleep doesn't count
+    if(!busy && !lcd.updating()) {                                              //nothing to do until some interrupt happens, and timer0's comes every 1.024ms at the latest
+        sleep_mode();                                                           //USB, the buttons, the ADC and the fader all wake it up too
+    }
+}
+
+//==============================================================================
+//scheduler tasks
+
+unsigned int animTask() {                                                       //steps the boot, sleep and disconnect sequences on the lcd
+    return lcd.animate();
+}
+
+unsigned int buttonsTask() {                                                    //monitors button changes and processes them
+    inout.checkButtons(!deadHost);                                              //nobody to tell about presses while the host is gone, but the queue still needs emptying
+    return BUTTONPERIOD;
+}
+
+unsigned int potTask() {                                                        //applies any changes made to the speed pot
+    int speed = inout.checkPot();
+    if(speed != lastSpeed) {
+        lastSpeed = speed;
+        lcd.setSpeed(speed);
+        sched.runIn(scrollId, 0);                                               //the scroll task may be waiting on the old speed
+    }
+    return POTPERIOD;
+}
+
+unsigned int rainbowTask() {                                                    //control the rainbow backlight changes
+    if(sleeping || deadHost) {                                                  //nothing to show while the lcd is off
+        return IDLEPOLL;
+    }
+    return inout.rainbow();
+}
+
+unsigned int scrollTask() {                                                     //scrolls the tweet
+    if(sleeping || deadHost) {                                                  //nothing to show while the lcd is off
+        return IDLEPOLL;
+    }
+    return lcd.scrollTweet();
+}
+
+unsigned int blinkTask() {                                                      //blinks the lcd if any new tweets are displayed
+    if(sleeping || deadHost) {                                                  //nothing to show while the lcd is off
+        return IDLEPOLL;
+    }
+    return inout.tweetBlink();
+}
+
+unsigned int saveTask() {                                                       //keeps the saved options up to date, a byte at a time
+    return opt.saveStep();
+}
+
+unsigned int logTask() {                                                        //appends shown tweets to the EEPROM log, a byte at a time
+    return twt.logStep();
+}
+
+unsigned int sleepTask() {                                                      //checks if the device needs to be sleeping
     checkSleep();
+    return SLEEPPERIOD;
 }
 
 void prepare() {                                                                //used to prepare the device for operation
     lcd.ranOnce = false;
     opt.defaults();                                                             //go back to all default options
+    opt.load();                                                                 //then the ones saved last time, so the boot animation already shows them
     lcd.sleepLCD(false);                                                        //get the LCD going
     comms.handshake();                                                          //establish a connection with the host program
     previousMillis2 = millis();                                                 //set previousMillis2 to the current time in preparation for the first checkForSleep
+    lastSof = millis();
+}
+
+void reconnect() {                                                              //the host came back: options and tweets are all still here, only the handshake is needed
+    lcd.ranOnce = false;
+    lcd.resume();                                                               //no boot animation, the lcd comes back on and fades in
+    comms.handshake();                                                          //shows the tweet again as soon as the host acks
+    previousMillis2 = millis();
+    lastSof = millis();
 }
 
 //==============================================================================
 
-void checkAlive() {                                                             //checks if the host died
+unsigned int checkAlive() {                                                     //checks if the host died, returns the ms until the next check is due
     unsigned long currentMillis = millis();                                     //get the current time
-     unsigned long currentAlive = comms.keepAlive;                              //get the current keepAlive value
-     if(currentMillis - previousMillis2 > ALIVEDELAY) {                         //only check for new keepalives every ALIVEDELAY
-         previousMillis2 = currentMillis;                                       //save the current time to use as a reference
-         if(currentAlive == previousAlive) {                                    //if the keepAlive values match (meaning we lost program/host connection)  
-             if(!deadHost) {                                                    //if we are not already sleeping
-                 deadHost = true;                                               //we will be now
-                 deadSleep();
-             }
-         }
-         else {                                                                 //the SOF counts are different (they're being updated, so it's connected)
-             previousAlive = currentAlive;                                      //save the current SOF to use as a reference
-             deadHost = false;                                                  //set this to true to wake up if nec
-         }
-     }
-}
-
-void checkSleep() {
-    if(opt.getSleep()) {
-        lcd.sleepLCD(true);                                                     //tell the lcd to sleep
-        while(opt.getSleep()) {                                                 //run some checks while the device is sleeping
-            comms.readComms();                                                  //checks for any new comms data, there could be a wakeup packet
-            inout.checkButtons();                                               //just in case a button was set to toggle sleep mode
-            checkAlive();                                                       //make sure the device is still connected to the host
+#if USB_COUNT_SOF
+    byte sof = usbSofCount;                                                     //V-USB counts a start of frame every 1ms while the bus is up
+    if(sof != previousSof) {
+        previousSof = sof;
+        lastSof = currentMillis;
+    }
+    bool busGone = opt.getSofTimeout() && currentMillis - lastSof >= opt.getSofTimeout();
+#else
+    bool busGone = false;                                                       //no start of frame counts, keepalives are all there is
+#endif
+    unsigned long aliveTime = opt.getAliveTime();
+    if(deadHost) {                                                              //the host is gone, watch for it coming back
+        if(busGone || (aliveTime && comms.keepAlive == previousAlive)) {        //with keepalives off the bus coming back is enough, the handshake finds out the rest
+            return DEADPOLL;
+        }
+        deadHost = false;                                                       //host is no longer dead
+        previousAlive = 0;                                                      //reset that to prevent problems with going back into deep sleep
+        if(currentMillis - deadSince < COLDAFTER) {
+            reconnect();                                                        //just a blip, carry on where we were
         }
-        lcd.wakeUp();                                                           //once we are no longer sleeping, wake the lcd up
+        else {
+            prepare();                                                          //prepare everything again
+        }
+        return SOFPOLL;
+    }
+    if(busGone) {                                                               //no frames, the host is asleep or the cable is out
+        hostDied();
+        return DEADPOLL;
+    }
+    if(!aliveTime) {                                                            //the host doesn't send keepalives, the bus is all there is to go on
+        previousMillis2 = currentMillis;
+        return SOFPOLL;
     }
+    unsigned long currentAlive = comms.keepAlive;                               //get the current keepAlive value
+    if(currentMillis - previousMillis2 > aliveTime) {                           //only check for new keepalives every aliveTime
+        previousMillis2 = currentMillis;                                        //save the current time to use as a reference
+        if(currentAlive == previousAlive) {                                     //if the keepAlive values match (meaning we lost program/host connection)
+            hostDied();
+            return DEADPOLL;
+        }
+        previousAlive = currentAlive;                                           //save the current keepAlive to use as a reference
+    }
+    unsigned long next = aliveTime - (currentMillis - previousMillis2) + 1;
+    return next < SOFPOLL ? next : SOFPOLL;
 }
 
-void deadSleep() {                                                              //used to make the device deep sleep, usually after the host died
-    if(opt.getSleep()) {                                                        //check if the device was already sleeping
-        lcd.sleepLCD(false);                                                    //turn the lcd back on
+void hostDied() {
+    deadHost = true;                                                            //we are going to sleep now
+    deadSleep();
+}
+
+void checkSleep() {                                                             //puts the lcd to sleep or wakes it up when the sleep option changes
+    if(deadHost || opt.getSleep() == sleeping) {                                //deadSleep() looks after the lcd while the host is gone
+        return;
+    }
+    sleeping = opt.getSleep();
+    if(sleeping) {
+        lcd.sleepLCD(true);                                                     //tell the lcd to sleep
+    }
+    else {
+        lcd.wakeUp();                                                           //no longer sleeping, wake the lcd up
     }
+}
+
+void deadSleep() {                                                              //used to make the device deep sleep, usually after the host died
+    sleeping = false;                                                           //the disconnect notice turns the lcd back on if it was sleeping
+    deadSince = millis();
     comms.setConnected(false);                                                  //tell comms that we are no longer connected to the host (so it can reconnect when we wake up)
-    lcd.disconnected();                                                         //make the lcd display a disconnected message
-    lcd.sleepLCD(true);                                                         //tell the lcd to sleep
+    lcd.disconnected();                                                         //make the lcd display a disconnected message, it goes to sleep after that
     inout.connectionLED(0);                                                     //turn the connection LED off, no longer connected
-    while(deadHost) {                                                           //run some checks while the device is "sleeping"
-        comms.readComms();                                                      //checks for any new comms data, there could be a new keepAlive packet
-        if(comms.keepAlive != previousAlive) {                                  //check if we still need to be sleeping
-            deadHost = false;                                                   //host is no longer dead
-            previousAlive = 0;                                                  //reset that to prevent problems with going back into deep sleep
-            prepare();                                                          //prepare everything again
-        }
-    }
-}
\ No newline at end of file
+}
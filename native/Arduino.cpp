@@ -0,0 +1,245 @@
+//Linux stand-in for the Arduino core: virtual clock, pins and the ADC
+#include "Arduino.h"
+#include "Sim.h"
+
+SimStats simStats;
+
+static uint64_t nowUs = 0;                                                      //virtual time since power on
+static uint8_t pinOut[NUM_PINS];                                                //values written by the firmware
+static uint8_t pinIn[NUM_PINS];                                                 //values driven by the simulation
+static int analogIn[NUM_PINS];
+static int pwmOut[NUM_PINS];
+static uint64_t nextTimer2 = SIM_TIMER2_US;
+static uint64_t nextTimer0 = SIM_TIMER0_US;
+static int analogNoise = 0;
+static uint32_t noiseSeed = 1;
+
+struct SimEdge {                                                                //a simSetPinAt() change still to come
+    uint64_t atUs;
+    uint8_t pin;
+    int val;
+};
+static SimEdge edges[SIM_PIN_EDGES];                                            //sorted by time
+static int edgeCount = 0;
+
+volatile uint8_t SREG;
+volatile uint8_t TCCR0A;
+volatile uint8_t TCCR1A;
+volatile uint8_t TIMSK2;
+volatile uint8_t OCR0A;
+volatile uint8_t OCR0B;
+volatile uint16_t OCR1A;
+volatile uint8_t PINC;
+volatile uint8_t PIND;
+volatile uint8_t PCICR;
+volatile uint8_t PCMSK1;
+volatile uint8_t PCMSK2;
+volatile uint8_t ADMUX;
+volatile uint8_t ADCSRA;
+volatile uint8_t ADCSRB;
+volatile uint16_t ADC;
+
+extern "C" void simTimer2Overflow(void) __attribute__((weak));                 //the firmware's ISRs, if it has them
+extern "C" void simPinChange1(void) __attribute__((weak));
+extern "C" void simPinChange2(void) __attribute__((weak));
+extern "C" void simAdcComplete(void) __attribute__((weak));
+
+static int convert(uint8_t pin) {                                               //one ADC conversion of an analog pin, noise included
+    int val = pin < NUM_PINS ? analogIn[pin] : 0;
+    if(analogNoise) {
+        noiseSeed = noiseSeed * 1103515245 + 12345;                             //same noise every run
+        val += (int)((noiseSeed >> 16) % (2 * analogNoise + 1)) - analogNoise;
+    }
+    return val < 0 ? 0 : (val > 1023 ? 1023 : val);
+}
+
+static void timer0Overflow() {                                                  //the ADC's timer0 auto trigger, the conversion's 104us aren't modelled
+    if((ADCSRA & _BV(ADEN)) && (ADCSRA & _BV(ADATE)) && (ADCSRB & 7) == _BV(ADTS2)) {
+        ADC = convert(A0 + (ADMUX & 7));
+        if((ADCSRA & _BV(ADIE)) && simAdcComplete) {
+            simStats.adcIsrs++;
+            simAdcComplete();
+        }
+    }
+}
+
+uint64_t simMicros() {
+    return nowUs;
+}
+
+void simAdvance(uint64_t us) {                                                  //moves the clock, running the interrupts that come due on the way at their own time
+    uint64_t end = nowUs + us;
+    while(true) {
+        uint64_t timer = nextTimer0 < nextTimer2 ? nextTimer0 : nextTimer2;
+        bool edge = edgeCount && edges[0].atUs <= timer;
+        uint64_t at = edge ? edges[0].atUs : timer;
+        if(at > end) {
+            break;
+        }
+        if(at > nowUs) {
+            nowUs = at;
+        }
+        if(edge) {
+            SimEdge e = edges[0];
+            memmove(edges, edges + 1, --edgeCount * sizeof(SimEdge));
+            simSetPin(e.pin, e.val);
+        }
+        else if(nextTimer0 < nextTimer2) {
+            nextTimer0 += SIM_TIMER0_US;
+            timer0Overflow();
+        }
+        else {
+            nextTimer2 += SIM_TIMER2_US;
+            if((TIMSK2 & _BV(TOIE2)) && simTimer2Overflow) {
+                simStats.timer2Isrs++;
+                simTimer2Overflow();
+            }
+        }
+    }
+    nowUs = end;
+}
+
+uint64_t simUsbNextUs();                                                        //next time the host gets a packet going, from HIDSerial.cpp
+
+void simSleep() {                                                               //idle sleep: the clock skips to the next interrupt that can wake the cpu
+    uint64_t wake = nextTimer0;                                                 //timer0 always runs, it's millis()
+    if((TIMSK2 & _BV(TOIE2)) && nextTimer2 < wake) {
+        wake = nextTimer2;
+    }
+    if(edgeCount && edges[0].atUs < wake) {
+        wake = edges[0].atUs;
+    }
+    uint64_t usb = simUsbNextUs();
+    if(usb < wake) {
+        wake = usb;
+    }
+    if(wake > nowUs) {
+        simStats.sleeps++;
+        simStats.sleepUs += wake - nowUs;
+        simAdvance(wake - nowUs);
+    }
+}
+
+void simResetStats() {
+    simStats = SimStats();
+    simStats.lastPollUs = nowUs;
+}
+
+void simSetPin(uint8_t pin, int val) {
+    if(pin >= NUM_PINS || pinIn[pin] == (val ? HIGH : LOW)) {
+        return;
+    }
+    pinIn[pin] = val ? HIGH : LOW;
+    if(pin < 8) {                                                               //port D, PCINT16-23
+        PIND = (PIND & ~_BV(pin)) | (val ? _BV(pin) : 0);
+        if((PCICR & _BV(PCIE2)) && (PCMSK2 & _BV(pin)) && simPinChange2) {
+            simStats.pinChangeIsrs++;
+            simPinChange2();
+        }
+    }
+    else if(pin >= A0) {                                                        //port C, PCINT8-13
+        PINC = (PINC & ~_BV(pin - A0)) | (val ? _BV(pin - A0) : 0);
+        if((PCICR & _BV(PCIE1)) && (PCMSK1 & _BV(pin - A0)) && simPinChange1) {
+            simStats.pinChangeIsrs++;
+            simPinChange1();
+        }
+    }
+}
+
+void simSetPinAt(uint64_t atUs, uint8_t pin, int val) {
+    if(atUs <= nowUs) {
+        simSetPin(pin, val);
+        return;
+    }
+    if(edgeCount == SIM_PIN_EDGES) {
+        abort();
+    }
+    int i = edgeCount++;
+    while(i > 0 && edges[i - 1].atUs > atUs) {                                  //keep them in time order, equal times in the order they were set
+        edges[i] = edges[i - 1];
+        i--;
+    }
+    edges[i].atUs = atUs;
+    edges[i].pin = pin;
+    edges[i].val = val;
+}
+
+void simSetAnalogNoise(int counts) {
+    analogNoise = counts;
+}
+
+int simGetPin(uint8_t pin) {
+    return pin < NUM_PINS ? pinOut[pin] : LOW;
+}
+
+void simSetAnalog(uint8_t pin, int val) {
+    if(pin < NUM_PINS) {
+        analogIn[pin] = val;
+    }
+}
+
+int simGetPwm(uint8_t pin) {                                                     //pins handed to a timer follow its compare register
+    if(pin == 9 && (TCCR1A & _BV(COM1A1))) {
+        return OCR1A;
+    }
+    if(pin == 5 && (TCCR0A & _BV(COM0B1))) {
+        return OCR0B;
+    }
+    if(pin == 6 && (TCCR0A & _BV(COM0A1))) {
+        return OCR0A;
+    }
+    return pin < NUM_PINS ? pwmOut[pin] : 0;
+}
+
+//==============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    simAdvance(SIM_DIGITALWRITE_US);
+    if(pin < NUM_PINS) {
+        pinOut[pin] = val ? HIGH : LOW;
+        pwmOut[pin] = val ? 255 : 0;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < NUM_PINS ? pinIn[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+    simAdvance(SIM_ANALOGREAD_US);
+    simStats.analogReads++;
+    return convert(pin >= A0 ? pin : A0 + pin);
+}
+
+void analogWrite(uint8_t pin, int val) {
+    simAdvance(SIM_ANALOGWRITE_US);
+    if(pin < NUM_PINS) {
+        pwmOut[pin] = val;
+        pinOut[pin] = val ? HIGH : LOW;
+    }
+}
+
+//==============================================================================
+
+unsigned long millis() {
+    return (unsigned long)(nowUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)nowUs;
+}
+
+void delay(unsigned long ms) {
+    simAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    simAdvance(us);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
@@ -0,0 +1,56 @@
+//Linux stand-in for the Arduino core, lets the firmware build and run natively
+//only covers what the TwiScn firmware actually uses, time is virtual (see Sim.h)
+#ifndef ARDUINO_H
+#define	ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "WString.h"
+#include "Print.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+//analog pin numbers of the atmega328p "standard" variant
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define NUM_PINS 20
+
+#define DEC 10
+#define HEX 16
+
+#define _BV(bit) (1 << (bit))
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void setup();
+void loop();
+
+#endif	/* ARDUINO_H */
+
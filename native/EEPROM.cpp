@@ -0,0 +1,47 @@
+//Linux stand-in for the Arduino EEPROM library
+//like avr-libc's eeprom_*_byte(), both calls first wait out a write that is still going, then a write keeps the cell busy
+#include "EEPROM.h"
+#include "Sim.h"
+
+EEPROMClass EEPROM;
+
+static uint8_t cells[E2END + 1];
+static unsigned long wear[E2END + 1];                                           //writes each cell has taken
+static bool erased = false;
+static uint64_t busyUntil = 0;                                                  //a write is in progress until then
+
+static void waitReady() {
+    if(!erased) {                                                               //a new chip reads all ones
+        memset(cells, 0xFF, sizeof(cells));
+        erased = true;
+    }
+    if(simMicros() < busyUntil) {
+        simAdvance(busyUntil - simMicros());
+    }
+}
+
+uint8_t EEPROMClass::read(int address) {
+    waitReady();
+    simAdvance(SIM_EEPROM_READ_US);
+    return cells[address & E2END];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    waitReady();
+    simAdvance(SIM_EEPROM_READ_US);
+    cells[address & E2END] = value;
+    wear[address & E2END]++;
+    simStats.eepromWrites++;
+    busyUntil = simMicros() + SIM_EEPROM_WRITE_US;
+}
+
+//==============================================================================
+
+unsigned long simEepromWear(int address) {
+    return wear[address & E2END];
+}
+
+void simEepromPoke(int address, uint8_t value) {
+    waitReady();
+    cells[address & E2END] = value;
+}
@@ -0,0 +1,15 @@
+//Linux stand-in for the Arduino EEPROM library, backed by the simulator's 1KB of EEPROM (see Sim.h)
+#ifndef EEPROM_H
+#define	EEPROM_H
+
+#include <Arduino.h>
+
+class EEPROMClass {
+    public:
+        uint8_t read(int address);
+        void write(int address, uint8_t value);
+};
+
+extern EEPROMClass EEPROM;
+
+#endif	/* EEPROM_H */
@@ -0,0 +1,361 @@
+//Linux stand-in for the HIDSerial library and V-USB's usbPoll(), plus a model of the host program
+#include "HIDSerial.h"
+#include "Sim.h"
+#include <stdio.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+
+struct HostPacket {
+    uint64_t atUs;                                                              //time the packet becomes readable
+    char data[SIM_PACKET_LEN + 1];                                              //fixed size so reading a packet never touches the heap
+};
+
+static std::deque<HostPacket> &hostQueue() {                                    //packets on their way to the firmware, sorted by time
+    static std::deque<HostPacket> queue;
+    return queue;
+}
+
+static std::string &lineOut() {                                                 //text printed by the firmware that has no newline yet
+    static std::string line;
+    return line;
+}
+
+static bool hostAlive = true;
+static uint64_t aliveChangeAt = 0;                                              //pending simHostAliveAt() change, 0 when there is none
+static bool aliveChangeTo = true;
+static bool busAlive = true;
+static uint64_t busSince = 0;                                                   //when the bus last came up
+static unsigned long sofBefore = 0;                                             //start of frames counted before that
+static bool ackPending = false;                                                 //a '~' handshake ack is already queued
+static unsigned long keepAlivePeriod = 0;
+static uint64_t nextKeepAlive = 0;
+static uint64_t nextReport = 0;                                                 //first time the interrupt-in endpoint is free again
+static uint64_t linkFree = 0;                                                   //the host sends its packets one after another
+static void (*lineHandler)(uint64_t atUs, const char *line) = NULL;
+static bool tracing = false;
+static uint64_t traceStart = 0;
+
+static std::vector<SimTraceEntry> &trace() {                                    //the recording, sorted by time when it's read
+    static std::vector<SimTraceEntry> entries;
+    return entries;
+}
+
+static void traceAdd(uint64_t atUs, bool fromHost, const std::string &data) {
+    if(!tracing) {
+        return;
+    }
+    SimTraceEntry entry;
+    entry.atUs = atUs - traceStart;
+    entry.fromHost = fromHost;
+    strncpy(entry.data, data.c_str(), SIM_TRACE_DATA);
+    entry.data[SIM_TRACE_DATA] = 0;
+    trace().push_back(entry);
+}
+
+static void queuePacket(uint64_t atUs, const std::string &data) {
+    std::deque<HostPacket> &queue = hostQueue();
+    std::deque<HostPacket>::iterator it = queue.end();
+    while(it != queue.begin() && (it - 1)->atUs > atUs) {                       //keep the queue in time order
+        --it;
+    }
+    traceAdd(atUs, true, data);
+    HostPacket packet;
+    packet.atUs = atUs;
+    strncpy(packet.data, data.c_str(), SIM_PACKET_LEN);
+    packet.data[SIM_PACKET_LEN] = 0;
+    queue.insert(it, packet);
+}
+
+static void updateAlive() {                                                     //applies a pending simHostAliveAt() once its time has come
+    if(aliveChangeAt && aliveChangeAt <= simMicros()) {
+        aliveChangeAt = 0;
+        simHostAlive(aliveChangeTo);
+    }
+}
+
+static void pumpHost() {                                                        //lets the host generate its periodic traffic up to now
+    updateAlive();
+    while(hostAlive && busAlive && keepAlivePeriod && nextKeepAlive <= simMicros()) {
+        queuePacket(nextKeepAlive, "%");
+        nextKeepAlive += (uint64_t)keepAlivePeriod * 1000;
+    }
+}
+
+static void hostReceive(const std::string &line) {                              //the host program got a full line from the firmware
+    updateAlive();
+    if(!busAlive) {                                                             //the report never leaves the device
+        return;
+    }
+    traceAdd(simMicros(), false, line);
+    if(line == "`" && hostAlive && !ackPending) {                               //answer handshake requests like the host program does
+        queuePacket(simMicros() + SIM_USB_FRAME_US, "~");
+        ackPending = true;
+    }
+    if(lineHandler) {
+        lineHandler(simMicros(), line.c_str());
+    }
+}
+
+//==============================================================================
+
+uint64_t simUsbNextUs() {                                                       //when V-USB's interrupt next has a packet to catch, for simSleep()
+    pumpHost();
+    uint64_t next = UINT64_MAX;
+    if(!hostQueue().empty()) {
+        next = hostQueue().front().atUs;
+    }
+    if(hostAlive && busAlive && keepAlivePeriod && nextKeepAlive < next) {
+        next = nextKeepAlive;
+    }
+    if(aliveChangeAt && aliveChangeAt < next) {                                 //not an interrupt, but the host coming back starts one
+        next = aliveChangeAt;
+    }
+    return next;
+}
+
+uint64_t simHostPacket(uint64_t atUs, const char *data) {
+    if(atUs < linkFree) {
+        atUs = linkFree;
+    }
+    queuePacket(atUs, std::string(data).substr(0, SIM_PACKET_LEN));
+    linkFree = atUs + SIM_USB_FRAME_US;
+    return linkFree;
+}
+
+uint64_t simHostPackets(uint64_t atUs, const char *data) {
+    std::string in(data);
+    for(size_t i = 0; i < in.length();) {
+        size_t length = SIM_PACKET_LEN;
+        if(in.length() - i == SIM_PACKET_LEN + 1 && (in[in.length() - 1] == '=' || in[in.length() - 1] == '%')) {
+            length--;                                                           //a lone '=' or '%' at the end would be a control packet
+        }
+        atUs = simHostPacket(atUs, in.substr(i, length).c_str());
+        i += length;
+    }
+    return atUs;
+}
+
+uint64_t simHostTransfer(uint64_t atUs, const char *data) {
+    return simHostPacket(simHostPackets(atUs, data), "=");
+}
+
+void simHostKeepAlive(unsigned long periodMs) {
+    keepAlivePeriod = periodMs;
+    nextKeepAlive = simMicros() + (uint64_t)periodMs * 1000;
+}
+
+void simHostAlive(bool alive) {
+    hostAlive = alive;
+    if(alive) {
+        nextKeepAlive = simMicros() + (uint64_t)keepAlivePeriod * 1000;
+    }
+}
+
+void simBusAlive(bool alive) {
+    if(alive == busAlive) {
+        return;
+    }
+    if(alive) {
+        busSince = simMicros();
+        nextKeepAlive = simMicros() + (uint64_t)keepAlivePeriod * 1000;
+    }
+    else {
+        sofBefore += (simMicros() - busSince) / SIM_USB_FRAME_US;
+    }
+    busAlive = alive;
+}
+
+uchar simSofCount() {
+    unsigned long count = sofBefore;
+    if(busAlive) {
+        count += (simMicros() - busSince) / SIM_USB_FRAME_US;
+    }
+    return count;
+}
+
+void simHostAliveAt(uint64_t atUs, bool alive) {
+    aliveChangeAt = atUs;
+    aliveChangeTo = alive;
+}
+
+void simHostOnLine(void (*handler)(uint64_t atUs, const char *line)) {
+    lineHandler = handler;
+}
+
+//==============================================================================
+//trace files are text, one entry a line: the time in us from the start of the recording, '<' for a packet from the
+//host or '>' for a line from the firmware, a space, then the data. bytes outside '!'..'~' and backslashes are
+//written as a backslash and two hex digits, so packed text and binary options survive. lines starting with '#'
+//are comments
+
+static bool sortedTrace = true;
+
+static bool earlier(const SimTraceEntry &a, const SimTraceEntry &b) {
+    return a.atUs < b.atUs;
+}
+
+void simTraceRecord(bool on) {
+    if(on) {
+        trace().clear();
+        traceStart = simMicros();
+    }
+    tracing = on;
+    sortedTrace = false;
+}
+
+unsigned long simTraceLength() {
+    return trace().size();
+}
+
+const SimTraceEntry &simTraceEntry(unsigned long i) {
+    if(!sortedTrace) {                                                          //packets get queued ahead of time, lines as they happen
+        std::stable_sort(trace().begin(), trace().end(), earlier);
+        sortedTrace = true;
+    }
+    return trace()[i];
+}
+
+bool simTraceSave(const char *path) {
+    FILE *out = fopen(path, "w");
+    if(!out) {
+        return false;
+    }
+    fprintf(out, "#TwiScn HID trace: us, < from the host or > from the device, data\n");
+    for(unsigned long i = 0; i < simTraceLength(); i++) {
+        const SimTraceEntry &e = simTraceEntry(i);
+        fprintf(out, "%llu %c ", (unsigned long long)e.atUs, e.fromHost ? '<' : '>');
+        for(const char *c = e.data; *c; c++) {
+            unsigned char b = *c;
+            if(b < '!' || b > '~' || b == '\\') {
+                fprintf(out, "\\%02x", b);
+            }
+            else {
+                fputc(b, out);
+            }
+        }
+        fputc('\n', out);
+    }
+    return fclose(out) == 0;
+}
+
+bool simTraceLoad(const char *path) {
+    FILE *in = fopen(path, "r");
+    if(!in) {
+        return false;
+    }
+    trace().clear();
+    char line[4 * SIM_TRACE_DATA + 32];
+    bool ok = true;
+    while(fgets(line, sizeof(line), in)) {
+        if(line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        unsigned long long at;
+        char dir;
+        int used = 0;
+        if(sscanf(line, "%llu %c %n", &at, &dir, &used) < 2 || (dir != '<' && dir != '>')) {
+            ok = false;
+            break;
+        }
+        SimTraceEntry entry;
+        entry.atUs = at;
+        entry.fromHost = dir == '<';
+        unsigned int length = 0;
+        for(const char *c = line + used; *c && *c != '\n' && length < SIM_TRACE_DATA; c++) {
+            unsigned int b = (unsigned char)*c;
+            if(b == '\\' && sscanf(c + 1, "%2x", &b) == 1) {
+                c += 2;
+            }
+            entry.data[length++] = b;
+        }
+        entry.data[length] = 0;
+        trace().push_back(entry);
+    }
+    fclose(in);
+    sortedTrace = false;
+    return ok;
+}
+
+void simTraceReplay(uint64_t atUs) {
+    bool wasTracing = tracing;
+    tracing = false;                                                            //the replay isn't part of the recording
+    for(unsigned long i = 0; i < simTraceLength(); i++) {
+        const SimTraceEntry &e = simTraceEntry(i);
+        if(e.fromHost && strcmp(e.data, "~") != 0) {
+            queuePacket(atUs + e.atUs, e.data);
+        }
+    }
+    tracing = wasTracing;
+}
+
+//==============================================================================
+
+void usbPoll() {
+    uint64_t now = simMicros();
+    if(now - simStats.lastPollUs > simStats.maxPollGapUs) {                     //simResetStats() starts the first gap
+        simStats.maxPollGapUs = now - simStats.lastPollUs;
+    }
+    simStats.lastPollUs = now;
+    simStats.usbPolls++;
+    simAdvance(SIM_USBPOLL_US);
+}
+
+HIDSerial::HIDSerial() {
+}
+
+void HIDSerial::begin() {
+    delay(255);                                                                 //the library forces a re-enumeration this long
+}
+
+void HIDSerial::poll() {
+    usbPoll();
+}
+
+unsigned char HIDSerial::available() {
+    pumpHost();
+    std::deque<HostPacket> &queue = hostQueue();
+    return busAlive && !queue.empty() && queue.front().atUs <= simMicros();  //packets sent while the bus is down wait for it
+}
+
+unsigned char HIDSerial::read(unsigned char *buffer) {
+    if(!available()) {
+        return 0;
+    }
+    HostPacket &packet = hostQueue().front();
+    unsigned char length = strlen(packet.data);
+    if(strcmp(packet.data, "~") == 0) {
+        ackPending = false;
+    }
+    simStats.packetsIn++;
+    memcpy(buffer, packet.data, length + 1);
+    hostQueue().pop_front();
+    return length;
+}
+
+size_t HIDSerial::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t HIDSerial::write(const uint8_t *buffer, size_t size) {                   //sends 8 byte reports, one per USB frame
+    for(size_t i = 0; i < size; i += 8) {
+        while(simMicros() < nextReport) {                                       //the library spins on usbPoll() until the endpoint is free
+            usbPoll();
+        }
+        nextReport = simMicros() + SIM_USB_FRAME_US;
+        simStats.reportsOut++;
+        for(size_t j = i; j < size && j < i + 8; j++) {
+            char c = buffer[j];
+            if(c == '\n') {
+                hostReceive(lineOut());
+                lineOut().clear();
+            }
+            else if(c != '\r') {
+                lineOut() += c;
+            }
+        }
+    }
+    return size;
+}
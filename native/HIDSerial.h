@@ -0,0 +1,21 @@
+//Linux stand-in for the HIDSerial library, the other end of the link is modelled in HIDSerial.cpp (see Sim.h)
+#ifndef HIDSERIAL_H
+#define	HIDSERIAL_H
+
+#include <Arduino.h>
+#include "usbdrv.h"
+
+class HIDSerial : public Print {
+    public:
+        HIDSerial();
+        void begin();
+        void poll();
+        unsigned char available();
+        unsigned char read(unsigned char *buffer);
+        virtual size_t write(uint8_t data);
+        virtual size_t write(const uint8_t *buffer, size_t size);
+        using Print::write;
+};
+
+#endif	/* HIDSERIAL_H */
+
@@ -0,0 +1,33 @@
+//counts heap allocations by interposing glibc's malloc family, the firmware's String use shows up in simStats.heapAllocs
+#include <stddef.h>
+#include <stdint.h>
+#include "Sim.h"
+
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t n, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+
+    void *malloc(size_t size) {
+        simStats.heapAllocs++;
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t n, size_t size) {
+        simStats.heapAllocs++;
+        return __libc_calloc(n, size);
+    }
+
+    void *realloc(void *ptr, size_t size) {
+        simStats.heapAllocs++;
+        return __libc_realloc(ptr, size);
+    }
+}
+
+//the native build can't know the avr memory layout, so the stack pointer is put SIM_FREE_RAM above the heap
+char __heap_start;
+char *__brkval = NULL;
+
+uint16_t simStackPointer() {
+    return (uint16_t)((uintptr_t)&__heap_start + SIM_FREE_RAM);
+}
@@ -0,0 +1,120 @@
+//Linux stand-in for the LiquidCrystal library
+#include "LiquidCrystal.h"
+#include "Sim.h"
+
+//one byte over the 4-bit bus: RS write, then two nibbles of 4 data writes and an enable pulse
+//(3 writes plus the library's 1+1+100us delays) each
+#define SIM_LCD_SEND_US (SIM_DIGITALWRITE_US + 2 * (7 * SIM_DIGITALWRITE_US + 102))
+#define SIM_LCD_CLEAR_US 2000                                                   //extra delay the library adds after clear()/home()
+#define SIM_LCD_ROWLEN 40                                                       //DDRAM length of each row in 2-line mode
+
+static char ddram[2][SIM_LCD_ROWLEN + 1];
+static uint8_t cgram[8][8];
+static uint8_t cursorCol = 0;
+static uint8_t cursorRow = 0;
+static uint8_t cgramAddr = 0;
+static bool cgramMode = false;                                                  //data writes go to CGRAM after a CGRAM address command
+static bool displayOn = false;
+static char rowOut[2][17];
+
+const char *simLcdRow(uint8_t row) {                                            //returns the 16 visible characters of a row
+    memcpy(rowOut[row & 1], ddram[row & 1], 16);
+    rowOut[row & 1][16] = 0;
+    return rowOut[row & 1];
+}
+
+bool simLcdOn() {
+    return displayOn;
+}
+
+const uint8_t *simLcdGlyph(uint8_t slot) {
+    return cgram[slot & 7];
+}
+
+//==============================================================================
+
+LiquidCrystal::LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3) {
+    memset(ddram, ' ', sizeof(ddram));
+}
+
+void LiquidCrystal::begin(uint8_t cols, uint8_t rows) {
+    delayMicroseconds(50000);                                                   //power on wait from the datasheet
+    for(int i = 0; i < 5; i++) {                                                //function set sequence and entry mode
+        command(0x20);
+    }
+    display();
+    clear();
+}
+
+void LiquidCrystal::command(uint8_t value) {                                    //decodes the instructions the firmware can send
+    simAdvance(SIM_LCD_SEND_US);
+    simStats.lcdCommands++;
+    if(value & 0x80) {                                                          //set DDRAM address
+        uint8_t addr = value & 0x7F;
+        cursorRow = addr >= 0x40 ? 1 : 0;
+        cursorCol = (addr & 0x3F) % SIM_LCD_ROWLEN;
+        cgramMode = false;
+    }
+    else if(value & 0x40) {                                                     //set CGRAM address
+        cgramAddr = value & 0x3F;
+        cgramMode = true;
+        simStats.cgramLoads++;
+    }
+    else if(value & 0x08) {                                                     //display on/off control
+        displayOn = value & 0x04;
+    }
+    else if(value == 0x01 || value == 0x02) {                                   //clear display, return home
+        simAdvance(SIM_LCD_CLEAR_US);
+        if(value == 0x01) {
+            memset(ddram, ' ', sizeof(ddram));
+        }
+        cursorCol = 0;
+        cursorRow = 0;
+        cgramMode = false;
+    }
+}
+
+size_t LiquidCrystal::write(uint8_t value) {
+    simAdvance(SIM_LCD_SEND_US);
+    simStats.lcdWrites++;
+    if(cgramMode) {
+        cgram[cgramAddr >> 3][cgramAddr & 7] = value;
+        cgramAddr = (cgramAddr + 1) & 0x3F;
+        return 1;
+    }
+    ddram[cursorRow][cursorCol] = value;
+    cursorCol++;
+    if(cursorCol == SIM_LCD_ROWLEN) {                                           //the address counter runs on into the other row
+        cursorCol = 0;
+        cursorRow ^= 1;
+    }
+    return 1;
+}
+
+void LiquidCrystal::clear() {
+    command(0x01);
+}
+
+void LiquidCrystal::home() {
+    command(0x02);
+}
+
+void LiquidCrystal::noDisplay() {
+    command(0x08);
+}
+
+void LiquidCrystal::display() {
+    command(0x0C);
+}
+
+void LiquidCrystal::setCursor(uint8_t col, uint8_t row) {
+    command(0x80 | (col + (row ? 0x40 : 0)));
+}
+
+void LiquidCrystal::createChar(uint8_t location, uint8_t charmap[]) {
+    location &= 0x7;
+    command(0x40 | (location << 3));
+    for(int i = 0; i < 8; i++) {
+        write(charmap[i]);
+    }
+}
@@ -0,0 +1,24 @@
+//Linux stand-in for the LiquidCrystal library
+//keeps a model of the HD44780's DDRAM/CGRAM and charges the 4-bit bus timing to the virtual clock
+#ifndef LIQUIDCRYSTAL_H
+#define	LIQUIDCRYSTAL_H
+
+#include <Arduino.h>
+
+class LiquidCrystal : public Print {
+    public:
+        LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3);
+        void begin(uint8_t cols, uint8_t rows);
+        void clear();
+        void home();
+        void noDisplay();
+        void display();
+        void setCursor(uint8_t col, uint8_t row);
+        void createChar(uint8_t location, uint8_t charmap[]);
+        void command(uint8_t value);
+        virtual size_t write(uint8_t value);
+        using Print::write;
+};
+
+#endif	/* LIQUIDCRYSTAL_H */
+
@@ -0,0 +1,81 @@
+//Linux stand-in for the Arduino Print class
+#include "Print.h"
+#include <stdio.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while(size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char *str) {
+    return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::print(const String &s) {
+    return write((const uint8_t *)s.c_str(), s.length());
+}
+
+size_t Print::print(const char *str) {
+    return write(str);
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(int n, int base) {
+    return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == 16 ? "%lx" : "%ld", n);
+    return write(buf);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == 16 ? "%lx" : "%lu", n);
+    return write(buf);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::println(const String &s) {
+    size_t n = print(s);
+    return n + println();
+}
+
+size_t Print::println(const char *str) {
+    size_t n = print(str);
+    return n + println();
+}
+
+size_t Print::println(char c) {
+    size_t n = print(c);
+    return n + println();
+}
+
+size_t Print::println(int n, int base) {
+    size_t r = print(n, base);
+    return r + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+    size_t r = print(n, base);
+    return r + println();
+}
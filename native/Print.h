@@ -0,0 +1,32 @@
+//Linux stand-in for the Arduino Print class
+#ifndef PRINT_H
+#define	PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "WString.h"
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size);
+        size_t write(const char *str);
+        size_t print(const String &s);
+        size_t print(const char *str);
+        size_t print(char c);
+        size_t print(unsigned char n, int base = 10);
+        size_t print(int n, int base = 10);
+        size_t print(unsigned int n, int base = 10);
+        size_t print(long n, int base = 10);
+        size_t print(unsigned long n, int base = 10);
+        size_t println();
+        size_t println(const String &s);
+        size_t println(const char *str);
+        size_t println(char c);
+        size_t println(int n, int base = 10);
+        size_t println(unsigned long n, int base = 10);
+};
+
+#endif	/* PRINT_H */
+
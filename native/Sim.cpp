@@ -0,0 +1,73 @@
+//helpers the benches share for driving the firmware through the simulator, and the host program's side of the frames
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+#include "Arduino.h"
+#include "Sim.h"
+#include "TextPack.h"
+
+void simRunFor(unsigned long ms) {                                              //keeps loop() going for ms of virtual time
+    uint64_t end = simMicros() + (uint64_t)ms * 1000;
+    while(simMicros() < end) {
+        loop();
+    }
+}
+
+bool simRunUntil(bool (*done)(), unsigned long ms) {                            //false if it didn't happen within ms
+    uint64_t end = simMicros() + (uint64_t)ms * 1000;
+    while(simMicros() < end) {
+        loop();
+        if(done()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int simPack(char *out, const char *text) {                             //greedy longest match against the dictionary
+    unsigned int n = 0;
+    while(*text) {
+        int best = -1;
+        unsigned int bestLen = 1;
+        for(int e = 0; e < PACKENTRIES; e++) {
+            const char *entry = packDict + e * PACKWIDTH;
+            unsigned int len = strnlen(entry, PACKWIDTH);
+            if(len > bestLen && strncmp(text, entry, len) == 0) {
+                best = e;
+                bestLen = len;
+            }
+        }
+        if(best >= 0) {
+            out[n++] = PACKFIRST + best;
+        }
+        else {
+            if((unsigned char)*text >= PACKFIRST) {
+                out[n++] = PACKESCAPE;
+            }
+            out[n++] = *text;
+        }
+        text += bestLen;
+    }
+    out[n] = 0;
+    return n;
+}
+
+unsigned int simMakeFrame(char *frame, const char *user, const char *text, bool packed) {  //frame needs SIM_FRAME_LEN bytes, returns its length
+    unsigned int crc = 0;
+    for(const char *c = user; *c; c++) {
+        crc = _crc_xmodem_update(crc, *c);
+    }
+    for(const char *c = text; *c; c++) {                                        //the crc is over the unpacked text either way
+        crc = _crc_xmodem_update(crc, *c);
+    }
+    char body[SIM_FRAME_LEN];
+    unsigned int bodyLen = packed ? simPack(body, text) : strlen(strcpy(body, text));
+    unsigned int length = snprintf(frame, SIM_FRAME_LEN, "%c%02x%03x%04x%s%s", packed ? '&' : '*', (unsigned int)strlen(user), bodyLen, crc, user, body);
+    return length < SIM_FRAME_LEN ? length : SIM_FRAME_LEN - 1;                 //cut off, no bench sends one that long
+}
+
+uint64_t simHostFrame(uint64_t atUs, const char *user, const char *text, bool packed) {    //returns when the next packet can follow
+    char frame[SIM_FRAME_LEN];
+    simMakeFrame(frame, user, text, packed);
+    return simHostPackets(atUs, frame);
+}
@@ -0,0 +1,99 @@
+//controls the virtual hardware the native build of the firmware runs against
+//time only moves when the firmware touches modelled hardware (or calls delay), so
+//every figure below is an estimate of time spent on a 16MHz atmega328p
+#ifndef SIM_H
+#define	SIM_H
+
+#include <stdint.h>
+
+//modelled cost of each hardware call in microseconds, taken from the Arduino 1.0.5 core
+#define SIM_DIGITALWRITE_US 4                                                   //digitalWrite() with its pin lookups
+#define SIM_ANALOGWRITE_US 6
+#define SIM_ANALOGREAD_US 112                                                   //13 ADC clocks at 125kHz plus overhead
+#define SIM_USBPOLL_US 4                                                        //idle usbPoll() with nothing to handle
+#define SIM_USB_FRAME_US 1000                                                   //one HID report can move per USB frame
+#define SIM_TIMER2_US 2040                                                      //timer2 overflow period, phase correct pwm at prescaler 64
+#define SIM_EEPROM_READ_US 1                                                    //EEPROM.read(), and write()'s part before the cell takes over
+#define SIM_EEPROM_WRITE_US 3400                                                //erase and write of one EEPROM cell, runs on its own
+#define SIM_TIMER0_US 1024                                                      //timer0 overflow period, the millis() timer
+#define SIM_FREE_RAM 600                                                        //bytes between the heap and the stack as the firmware sees them, see Heap.cpp
+#define SIM_PIN_EDGES 256                                                       //simSetPinAt() edges that can be pending at once
+#define SIM_TRACE_DATA 63                                                       //longest packet or line a trace entry keeps
+#define SIM_PACKET_LEN 31                                                       //usbBuffer is 32 bytes and needs its terminator
+#define SIM_FRAME_LEN 700                                                       //simMakeFrame() buffer, fits a 280 char text packed at its worst
+
+struct SimStats {
+    unsigned long usbPolls;                                                     //number of usbPoll() calls
+    uint64_t lastPollUs;                                                        //time of the last usbPoll() call
+    uint64_t maxPollGapUs;                                                      //longest time between two usbPoll() calls
+    unsigned long lcdCommands;                                                  //HD44780 instructions (clear, cursor moves, ...)
+    unsigned long lcdWrites;                                                    //HD44780 data writes (characters)
+    unsigned long cgramLoads;                                                   //custom chars written to CGRAM
+    unsigned long packetsIn;                                                    //32 byte packets read by the firmware
+    unsigned long reportsOut;                                                   //8 byte reports sent by the firmware
+    unsigned long analogReads;
+    unsigned long heapAllocs;                                                   //malloc/calloc/realloc calls, firmware and simulator alike
+    unsigned long timer2Isrs;                                                   //timer2 overflow interrupts run (their time isn't charged)
+    unsigned long pinChangeIsrs;                                                //pin change interrupts run, same
+    unsigned long adcIsrs;                                                      //ADC conversion complete interrupts run, same
+    unsigned long eepromWrites;                                                 //EEPROM cells written
+    unsigned long sleeps;                                                       //times the firmware idled the cpu
+    uint64_t sleepUs;                                                           //time it spent idle, the rest of the time it was running
+};
+
+extern SimStats simStats;
+
+//virtual clock
+uint64_t simMicros();
+void simAdvance(uint64_t us);
+void simResetStats();
+void simRunFor(unsigned long ms);                                               //keeps loop() going for ms of virtual time
+bool simRunUntil(bool (*done)(), unsigned long ms);                             //same until done() says so, false if it didn't within ms
+
+//pins
+void simSetPin(uint8_t pin, int val);                                           //drives an input pin, firing its pin change interrupt if enabled
+void simSetPinAt(uint64_t atUs, uint8_t pin, int val);                          //same at atUs, works while the firmware blocks
+int simGetPin(uint8_t pin);                                                     //reads back a digital output
+void simSetAnalog(uint8_t pin, int val);                                        //sets what analogRead() and the ADC return
+void simSetAnalogNoise(int counts);                                             //every conversion reads up to counts off, either way
+int simGetPwm(uint8_t pin);                                                     //reads back a pin's pwm duty, 0-255
+
+//LCD
+const char *simLcdRow(uint8_t row);                                             //current DDRAM contents of a row, 16 chars
+bool simLcdOn();
+const uint8_t *simLcdGlyph(uint8_t slot);                                       //the 8 rows of a custom char as they are in CGRAM
+
+//EEPROM, erased at start and kept for the whole run, so prepare() sees what the last "power cycle" saved
+unsigned long simEepromWear(int address);                                       //writes one cell has taken so far
+void simEepromPoke(int address, uint8_t value);                                 //changes a cell behind the firmware's back, like a write cut off by a power loss
+
+//host side of the HIDSerial link
+uint64_t simHostPacket(uint64_t atUs, const char *data);                        //queues one packet, returns when the next one can follow
+uint64_t simHostPackets(uint64_t atUs, const char *data);                       //splits data into packets, without a terminator
+uint64_t simHostTransfer(uint64_t atUs, const char *data);                      //same and adds the '=' terminator
+unsigned int simPack(char *out, const char *text);                              //packs text with the TextPack dictionary like the host program does, returns the bytes
+unsigned int simMakeFrame(char *frame, const char *user, const char *text, bool packed);    //builds a '*' tweet frame, '&' with the text packed
+uint64_t simHostFrame(uint64_t atUs, const char *user, const char *text, bool packed);      //builds one and sends it
+void simHostKeepAlive(unsigned long periodMs);                                  //sends '%' every periodMs, 0 disables
+void simHostAlive(bool alive);                                                  //a dead host sends nothing and acks nothing
+void simHostAliveAt(uint64_t atUs, bool alive);                                 //same but takes effect at atUs, works while the firmware blocks
+void simBusAlive(bool alive);                                                   //a dead bus has no start of frames, and nothing gets through either way
+void simHostOnLine(void (*handler)(uint64_t atUs, const char *line));           //called for every line the firmware prints
+
+//HID traces: the packets the host sends and the lines the firmware prints, with their times. the file format is in HIDSerial.cpp
+struct SimTraceEntry {
+    uint64_t atUs;                                                              //from the start of the recording
+    bool fromHost;                                                              //a packet to the firmware, otherwise a line from it
+    char data[SIM_TRACE_DATA + 1];
+};
+
+void simTraceRecord(bool on);                                                   //starts a new recording (times count from now) or stops it
+unsigned long simTraceLength();
+const SimTraceEntry &simTraceEntry(unsigned long i);                            //entries in time order
+bool simTraceSave(const char *path);
+bool simTraceLoad(const char *path);                                            //replaces the recording with the file's
+void simTraceReplay(uint64_t atUs);                                             //queues the recording's host packets as if it started at atUs, the handshake
+                                                                                //ack is left to the host model
+
+#endif	/* SIM_H */
+
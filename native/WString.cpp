@@ -0,0 +1,212 @@
+//Linux stand-in for the Arduino String class
+#include "WString.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+String::String(const char *cstr) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    if(cstr) {
+        copy(cstr, strlen(cstr));
+    }
+}
+
+String::String(const String &str) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    copy(str.buffer ? str.buffer : "", str.len);
+}
+
+String::String(char c) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    char buf[2] = {c, 0};
+    copy(buf, 1);
+}
+
+String::String(int value, unsigned char base) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    char buf[34];
+    snprintf(buf, sizeof(buf), base == 16 ? "%x" : "%d", value);
+    copy(buf, strlen(buf));
+}
+
+String::String(unsigned int value, unsigned char base) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    char buf[34];
+    snprintf(buf, sizeof(buf), base == 16 ? "%x" : "%u", value);
+    copy(buf, strlen(buf));
+}
+
+String::String(long value, unsigned char base) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    char buf[34];
+    snprintf(buf, sizeof(buf), base == 16 ? "%lx" : "%ld", value);
+    copy(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) {
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+    char buf[34];
+    snprintf(buf, sizeof(buf), base == 16 ? "%lx" : "%lu", value);
+    copy(buf, strlen(buf));
+}
+
+String::~String() {
+    free(buffer);
+}
+
+//==============================================================================
+
+bool String::reserve(unsigned int size) {                                       //grows the buffer the same way the Arduino core does
+    if(buffer && capacity >= size) {
+        return true;
+    }
+    char *newbuffer = (char *)realloc(buffer, size + 1);
+    if(!newbuffer) {
+        return false;
+    }
+    if(!buffer) {
+        newbuffer[0] = 0;
+    }
+    buffer = newbuffer;
+    capacity = size;
+    return true;
+}
+
+void String::copy(const char *cstr, unsigned int length) {
+    if(!reserve(length)) {
+        return;
+    }
+    len = length;
+    memcpy(buffer, cstr, length);
+    buffer[len] = 0;
+}
+
+bool String::concat(const char *cstr, unsigned int length) {
+    if(length == 0) {
+        return true;
+    }
+    if(!reserve(len + length)) {
+        return false;
+    }
+    memcpy(buffer + len, cstr, length);
+    len += length;
+    buffer[len] = 0;
+    return true;
+}
+
+//==============================================================================
+
+String &String::operator=(const String &rhs) {
+    if(this != &rhs) {
+        copy(rhs.c_str(), rhs.len);
+    }
+    return *this;
+}
+
+String &String::operator=(const char *cstr) {
+    copy(cstr, strlen(cstr));
+    return *this;
+}
+
+String &String::operator+=(const String &rhs) {
+    concat(rhs.c_str(), rhs.len);
+    return *this;
+}
+
+String &String::operator+=(const char *cstr) {
+    concat(cstr, strlen(cstr));
+    return *this;
+}
+
+String &String::operator+=(char c) {
+    concat(&c, 1);
+    return *this;
+}
+
+bool String::operator==(const String &rhs) const {
+    return len == rhs.len && strcmp(c_str(), rhs.c_str()) == 0;
+}
+
+bool String::operator==(const char *cstr) const {
+    return strcmp(c_str(), cstr) == 0;
+}
+
+bool String::operator!=(const String &rhs) const {
+    return !(*this == rhs);
+}
+
+bool String::operator!=(const char *cstr) const {
+    return !(*this == cstr);
+}
+
+//==============================================================================
+
+unsigned int String::length() const {
+    return len;
+}
+
+char String::charAt(unsigned int index) const {
+    if(index >= len) {
+        return 0;
+    }
+    return buffer[index];
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, len);
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if(beginIndex > endIndex) {                                                 //the Arduino core swaps reversed bounds
+        unsigned int temp = endIndex;
+        endIndex = beginIndex;
+        beginIndex = temp;
+    }
+    String out;
+    if(beginIndex >= len) {
+        return out;
+    }
+    if(endIndex > len) {
+        endIndex = len;
+    }
+    out.copy(buffer + beginIndex, endIndex - beginIndex);
+    return out;
+}
+
+long String::toInt() const {
+    return atol(c_str());
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+    if(!bufsize || !buf) {
+        return;
+    }
+    if(index >= len) {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = bufsize - 1;
+    if(n > len - index) {
+        n = len - index;
+    }
+    memcpy(buf, buffer + index, n);
+    buf[n] = 0;
+}
+
+const char *String::c_str() const {
+    return buffer ? buffer : "";
+}
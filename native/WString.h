@@ -0,0 +1,44 @@
+//Linux stand-in for the Arduino String class
+//heap behaviour mirrors the real one (malloc/realloc per growth, copy per substring)
+#ifndef WSTRING_H
+#define	WSTRING_H
+
+#include <stddef.h>
+
+class String {
+    public:
+        String(const char *cstr = "");
+        String(const String &str);
+        String(char c);
+        String(int value, unsigned char base = 10);
+        String(unsigned int value, unsigned char base = 10);
+        String(long value, unsigned char base = 10);
+        String(unsigned long value, unsigned char base = 10);
+        ~String();
+        String &operator=(const String &rhs);
+        String &operator=(const char *cstr);
+        String &operator+=(const String &rhs);
+        String &operator+=(const char *cstr);
+        String &operator+=(char c);
+        bool operator==(const String &rhs) const;
+        bool operator==(const char *cstr) const;
+        bool operator!=(const String &rhs) const;
+        bool operator!=(const char *cstr) const;
+        unsigned int length() const;
+        char charAt(unsigned int index) const;
+        String substring(unsigned int beginIndex) const;
+        String substring(unsigned int beginIndex, unsigned int endIndex) const;
+        long toInt() const;
+        void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const;
+        const char *c_str() const;
+    private:
+        void copy(const char *cstr, unsigned int length);
+        bool concat(const char *cstr, unsigned int length);
+        bool reserve(unsigned int size);
+        char *buffer;
+        unsigned int capacity;
+        unsigned int len;
+};
+
+#endif	/* WSTRING_H */
+
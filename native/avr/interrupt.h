@@ -0,0 +1,16 @@
+//Linux stand-in for avr-libc's interrupt header
+//an ISR is a plain function the simulated timer or pins call, see simAdvance() and simSetPin() in Arduino.cpp
+#ifndef INTERRUPT_H
+#define	INTERRUPT_H
+
+#define ISR_NOBLOCK
+#define ISR(vector, ...) extern "C" void vector(void)
+#define TIMER2_OVF_vect simTimer2Overflow
+#define PCINT1_vect simPinChange1
+#define PCINT2_vect simPinChange2
+#define ADC_vect simAdcComplete
+
+#define cli()
+#define sei()
+
+#endif	/* INTERRUPT_H */
@@ -0,0 +1,48 @@
+//Linux stand-in for the few atmega328p registers the firmware touches directly
+//the simulation reads the pwm compare registers back through simGetPwm() and drives the input ones from simSetPin()
+#ifndef IO_H_AVR
+#define	IO_H_AVR
+
+#include <stdint.h>
+
+extern volatile uint8_t SREG;
+extern volatile uint8_t TCCR0A;
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TIMSK2;
+extern volatile uint8_t OCR0A;
+extern volatile uint8_t OCR0B;
+extern volatile uint16_t OCR1A;
+extern volatile uint8_t PINC;                                                   //input levels, kept in step with simSetPin()
+extern volatile uint8_t PIND;
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADCSRB;
+extern volatile uint16_t ADC;                                                   //last conversion, filled in by the simulated ADC
+uint16_t simStackPointer();
+#define SP simStackPointer()                                                    //the stack pointer, only ever read to work out free ram
+
+#define E2END 0x3FF                                                             //last EEPROM address
+
+#define COM0A1 7
+#define COM0B1 5
+#define COM1A1 7
+#define TOIE2 0
+#define PINC3 3
+#define PIND4 4
+#define PCIE1 1
+#define PCIE2 2
+#define PCINT11 3
+#define PCINT20 4
+#define REFS0 6
+#define ADEN 7
+#define ADATE 5
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define ADTS2 2
+
+#endif	/* IO_H_AVR */
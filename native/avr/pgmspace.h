@@ -0,0 +1,19 @@
+//Linux stand-in for avr-libc's program memory helpers, flash is just ordinary memory here
+#ifndef PGMSPACE_H
+#define	PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char *
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+typedef char prog_char;
+typedef uint8_t prog_uchar;
+
+#endif	/* PGMSPACE_H */
+
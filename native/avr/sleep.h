@@ -0,0 +1,13 @@
+//Linux stand-in for avr-libc's sleep header
+//sleeping moves the virtual clock on to the next interrupt, see simSleep() in Arduino.cpp
+#ifndef SLEEP_H
+#define	SLEEP_H
+
+#define SLEEP_MODE_IDLE 0
+
+void simSleep();
+
+#define set_sleep_mode(mode)
+#define sleep_mode() simSleep()
+
+#endif	/* SLEEP_H */
@@ -0,0 +1,11 @@
+//Linux stand-in for avr-libc's watchdog header, there is no watchdog to feed natively
+#ifndef WDT_H
+#define	WDT_H
+
+#define WDTO_1S 6
+#define wdt_enable(timeout)
+#define wdt_disable()
+#define wdt_reset()
+
+#endif	/* WDT_H */
+
@@ -0,0 +1,124 @@
+//button gestures: scripted bouncy presses on FN1 and FN2, once with loop() running freely and once with it stuck for
+//200ms at a time, and what the host program gets told. latency counts from when the gesture could first be told apart
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+
+#define MAXREPORTS 64
+#define BOUNCEUS 400                                                            //the contacts bounce once, this long after each edge
+
+struct Gesture {
+    uint8_t pin;
+    char button;
+    char type;                                                                  //GESTURESHORT, GESTURELONG or GESTUREDOUBLE
+    unsigned long atMs;                                                         //first press, from the start of the phase
+};
+
+struct Report {
+    uint64_t atUs;
+    char text[4];
+};
+
+static const Gesture script[] = {
+    {FN1PIN, '1', GESTURESHORT, 0},
+    {FN2PIN, '2', GESTURESHORT, 1500},
+    {FN1PIN, '1', GESTURELONG, 3000},
+    {FN2PIN, '2', GESTUREDOUBLE, 4500},
+    {FN1PIN, '1', GESTUREDOUBLE, 6000},
+    {FN2PIN, '2', GESTURELONG, 7500},
+    {FN1PIN, '1', GESTURESHORT, 9000},
+    {FN2PIN, '2', GESTURESHORT, 10500},
+};
+#define GESTURES (sizeof(script) / sizeof(script[0]))
+#define PHASEMS 12500
+
+static Report reports[MAXREPORTS];
+static int reportCount = 0;
+
+static void onLine(uint64_t atUs, const char *line) {                           //button reports are the button number and maybe a gesture letter
+    if((line[0] == '1' || line[0] == '2') && strlen(line) <= 2 && reportCount < MAXREPORTS) {
+        reports[reportCount].atUs = atUs;
+        strcpy(reports[reportCount].text, line);
+        reportCount++;
+    }
+}
+
+static void edge(uint64_t atUs, uint8_t pin, int val) {                         //an edge with one bounce back and forth after it
+    simSetPinAt(atUs, pin, val);
+    simSetPinAt(atUs + BOUNCEUS / 2, pin, !val);
+    simSetPinAt(atUs + BOUNCEUS, pin, val);
+}
+
+static uint64_t schedule(const Gesture &g, uint64_t start) {                    //queues the gesture's edges, returns when it can be told apart
+    uint64_t at = start + (uint64_t)g.atMs * 1000;
+    switch(g.type) {
+        case GESTURESHORT:
+            edge(at, g.pin, HIGH);
+            edge(at + 120000, g.pin, LOW);
+            return at + 120000 + (uint64_t)BTNDOUBLE * 1000;                    //nothing else came within the double press window
+        case GESTURELONG:
+            edge(at, g.pin, HIGH);
+            edge(at + 900000, g.pin, LOW);
+            return at + (uint64_t)BTNLONG * 1000;
+        default:
+            edge(at, g.pin, HIGH);
+            edge(at + 100000, g.pin, LOW);
+            edge(at + 250000, g.pin, HIGH);
+            edge(at + 350000, g.pin, LOW);
+            return at + 350000;
+    }
+}
+
+static void runPhase(const char *name, unsigned long stuckMs) {                 //plays the script, loop() gets stuck for stuckMs after every call
+    uint64_t start = simMicros() + 10000;
+    uint64_t known[GESTURES];
+    for(unsigned int i = 0; i < GESTURES; i++) {
+        known[i] = schedule(script[i], start);
+    }
+    reportCount = 0;
+    simResetStats();
+    uint64_t end = start + (uint64_t)PHASEMS * 1000;
+    while(simMicros() < end) {
+        loop();
+        if(stuckMs) {
+            delay(stuckMs);
+        }
+    }
+    unsigned int right = 0;
+    double worst = 0;
+    double total = 0;
+    for(unsigned int i = 0; i < GESTURES; i++) {
+        char want[4] = {script[i].button, script[i].type, '\0', '\0'};
+        if(script[i].type == GESTURESHORT) {
+            want[1] = '\0';
+        }
+        if((int)i < reportCount && !strcmp(reports[i].text, want)) {
+            right++;
+            double ms = ((double)reports[i].atUs - (double)known[i]) / 1000.0;
+            total += ms;
+            if(ms > worst) {
+                worst = ms;
+            }
+        }
+    }
+    printf("  %-14s %6u/%-3u %8d %12.1f %12.1f %12lu\n", name, right, (unsigned int)GESTURES, reportCount,
+           right ? total / right : 0.0, worst, simStats.pinChangeIsrs);
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    simHostOnLine(onLine);
+    setup();
+    uint64_t end = simMicros() + 1000000;
+    while(simMicros() < end) {
+        loop();
+    }
+
+    printf("TwiScn button gestures, %u scripted short/long/double presses with contact bounce\n", (unsigned int)GESTURES);
+    printf("  %-14s %10s %8s %12s %12s %12s\n", "loop()", "right", "reports", "mean ms", "worst ms", "edges");
+    runPhase("free running", 0);
+    runPhase("stuck 200ms", 200);
+    return 0;
+}
@@ -0,0 +1,89 @@
+//backlight fades: samples the backlight pins while loop() runs through a sleep fade out, the wake fade in, and a rainbow section.
+//the fader steps from the timer2 interrupt, so loop() should have next to nothing to do meanwhile
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+
+extern IO inout;
+
+struct Fade {
+    uint64_t firstUs;                                                           //first and last change of the sampled channel
+    uint64_t lastUs;
+    unsigned long changes;
+    int from;
+    int to;
+    int maxJump;                                                                //biggest duty change seen between two samples
+    bool monotonic;
+    uint64_t sleepUs;                                                           //time loop() had the cpu idle
+    unsigned long isrs;
+    uint64_t us;                                                                //how long loop() ran for
+};
+
+static int duty(uint8_t pin) {                                                  //the leds are common anode, so low is on
+    return 255 - simGetPwm(pin);
+}
+
+static Fade watch(uint8_t pin, uint64_t forUs, bool untilDone) {               //runs loop() for forUs (or until the fade it saw finishes) and tracks how one channel moves
+    Fade f = {0, 0, 0, duty(pin), duty(pin), 0, true, 0, 0, 0};
+    uint64_t sleepUs = simStats.sleepUs;
+    int last = f.from;
+    int direction = 0;
+    unsigned long isrs = simStats.timer2Isrs;
+    uint64_t start = simMicros();
+    uint64_t end = start + forUs;
+    while(simMicros() < end && !(untilDone && f.changes && !inout.fading())) {
+        loop();
+        int now = duty(pin);
+        if(now == last) {
+            continue;
+        }
+        if(!f.changes) {
+            f.firstUs = simMicros();
+        }
+        f.lastUs = simMicros();
+        f.changes++;
+        int d = now > last ? 1 : -1;
+        if(direction && d != direction) {
+            f.monotonic = false;
+        }
+        direction = d;
+        if(abs(now - last) > f.maxJump) {
+            f.maxJump = abs(now - last);
+        }
+        last = now;
+    }
+    f.to = last;
+    f.isrs = simStats.timer2Isrs - isrs;
+    f.us = simMicros() - start;
+    f.sleepUs = simStats.sleepUs - sleepUs;
+    return f;
+}
+
+static void print(const char *phase, const Fade &f) {
+    printf("  %-14s %4d -> %-4d %10.1f %8lu %9d %10s %9.1f%%\n", phase, f.from, f.to,
+           f.changes ? (f.lastUs - f.firstUs) / 1000.0 : 0.0, f.changes, f.maxJump, f.monotonic ? "yes" : "NO", 100.0 - 100.0 * f.sleepUs / f.us);
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    setup();
+    simHostTransfer(simMicros(), "$b255");
+    watch(BLUELITE, 100000, false);
+
+    printf("TwiScn backlight fades (blue channel, rainbow on red), duty 0-255\n");
+    printf("  %-14s %12s %10s %8s %9s %10s %12s\n", "phase", "duty", "took ms", "steps", "max jump", "monotonic", "cpu awake");
+    simHostTransfer(simMicros(), "$s1");                                        //standby: 2s notice, then the fade out
+    Fade sleep = watch(BLUELITE, 4000000, false);
+    print("sleep", sleep);
+    simHostTransfer(simMicros(), "$s0");
+    Fade wake = watch(BLUELITE, 2000000, false);
+    print("wake", wake);
+    simHostTransfer(simMicros(), "$e100020");                                   //rainbow, 21ms per level so 5376ms for the first color section (blue to red)
+    Fade rainbow = watch(REDLITE, 10000000, true);                              //the next section starts right after, so stop once red is there
+    print("rainbow", rainbow);
+    printf("fader interrupts during the rainbow: %lu (one per %.2fms)\n", rainbow.isrs, rainbow.us / 1000.0 / rainbow.isrs);
+    return 0;
+}
@@ -0,0 +1,106 @@
+//tweet delivery: the '@' '=' '!' '=' transfer pair against a single CRC checked '*' frame
+//counts packets and the virtual time from the first packet until the tweet is queued, then checks that damaged frames get refused
+//with "*e" and an intact one that's too long with "*l". a '!' packet that looks like a frame header has to stay text
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../TweetHandler.h"
+
+extern TweetHandler twt;
+
+static unsigned long rejects = 0;
+static unsigned long tooLong = 0;
+
+static void onLine(uint64_t atUs, const char *line) {                           //counts the device refusing frames
+    if(strcmp(line, "*e") == 0) {
+        rejects++;
+    }
+    if(strcmp(line, "*l") == 0) {
+        tooLong++;
+    }
+}
+
+static void makeTweet(char *text, int n) {
+    static const char words[] = "the quick brown fox jumps over the lazy dog ";
+    int start = sprintf(text, "#%d ", n);
+    for(int i = start; i < 280; i++) {
+        text[i] = words[(i - start) % (sizeof(words) - 1)];
+    }
+    text[280] = 0;
+}
+
+static uint64_t waitQueued(const char *text, uint64_t limitUs) {               //runs loop() until the tweet is queued (or already moved up), returns how long that took
+    while(twt.nextTweet()) {                                                    //the lcd would take its time getting there, skip ahead
+    }
+    uint64_t start = simMicros();
+    while(!twt.getPending() && strcmp(twt.getTweet(true), text) != 0 && simMicros() - start < limitUs) {
+        loop();
+    }
+    return simMicros() - start;
+}
+
+int main(int argc, char **argv) {
+    int tweets = argc > 1 ? atoi(argv[1]) : 20;
+    char text[300];
+    char frame[SIM_FRAME_LEN];
+    simHostKeepAlive(1000);
+    simHostOnLine(onLine);
+    setup();
+
+    unsigned long pairPackets = 0;
+    unsigned long framePackets = 0;
+    uint64_t pairUs = 0;
+    uint64_t frameUs = 0;
+    for(int i = 0; i < tweets; i++) {
+        char transfer[sizeof(text) + 1];                                        //the text with the '!' in front
+        makeTweet(text, 2 * i);
+        snprintf(transfer, sizeof(transfer), "!%s", text);
+        uint64_t at = simHostTransfer(simMicros(), "@TwiScnBench");
+        simHostTransfer(at, transfer);
+        pairPackets += 2 + (281 + SIM_PACKET_LEN - 1) / SIM_PACKET_LEN + 1;
+        pairUs += waitQueued(text, 5000000);
+
+        makeTweet(text, 2 * i + 1);
+        unsigned int frameLength = simMakeFrame(frame, "@TwiScnBench", text, false);
+        framePackets += (frameLength + SIM_PACKET_LEN - 1) / SIM_PACKET_LEN;
+        simHostPackets(simMicros(), frame);
+        frameUs += waitQueued(text, 5000000);
+    }
+
+    //damaged frames: one flipped character in the text, and a header that lies about the length
+    makeTweet(text, 1000);
+    simMakeFrame(frame, "@TwiScnBench", text, false);
+    frame[100] ^= 1;
+    simHostPackets(simMicros(), frame);
+    bool flippedShown = waitQueued(text, 200000) < 200000;
+    makeTweet(text, 1001);
+    int length = simMakeFrame(frame, "@TwiScnBench", text, false);
+    frame[5] = '0';                                                             //text length 0x0xx instead of 0x118
+    simHostPackets(simMicros(), frame);
+    bool shortShown = waitQueued(text, 200000) < 200000;
+    makeTweet(text, 1002);                                                      //and a good frame afterwards still gets through
+    simHostFrame(simMicros(), "@TwiScnBench", text, false);
+    bool recovered = waitQueued(text, 5000000) < 5000000;
+    memset(text, 'x', 290);                                                     //an intact frame with 290 chars of text, a resend won't make it fit
+    text[290] = 0;
+    simHostFrame(simMicros(), "@TwiScnBench", text, false);
+    simRunFor(200);
+    makeTweet(text, 1003);
+    memcpy(text + 30, "*0c0101234", 10);                                        //the second packet of the '!' transfer starts with a frame header
+    char transfer[sizeof(text) + 1];
+    snprintf(transfer, sizeof(transfer), "!%s", text);
+    simHostTransfer(simHostTransfer(simMicros(), "@TwiScnBench"), transfer);
+    bool headerText = waitQueued(text, 5000000) < 5000000;
+
+    printf("TwiScn tweet delivery, %d tweets of 280 characters each way\n", tweets);
+    printf("  %-10s %14s %22s\n", "transfer", "packets/tweet", "first packet to queue ms");
+    printf("  %-10s %14.1f %22.1f\n", "@ ! pair", (double)pairPackets / tweets, pairUs / 1000.0 / tweets);
+    printf("  %-10s %14.1f %22.1f\n", "* frame", (double)framePackets / tweets, frameUs / 1000.0 / tweets);
+    printf("damaged frames: %lu refused, flipped bit queued: %s, bad length queued: %s, next good frame queued: %s (%d byte frame)\n",
+           rejects, flippedShown ? "YES" : "no", shortShown ? "YES" : "no", recovered ? "yes" : "NO", length);
+    printf("too long frame: %s, '!' text that looks like a frame header queued: %s\n", tooLong == 1 ? "answered \"*l\"" : "NOT answered \"*l\"",
+           headerText ? "yes" : "NO");
+    return 0;
+}
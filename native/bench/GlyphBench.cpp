@@ -0,0 +1,144 @@
+//utf-8 tweets on the lcd: scrolls each sample tweet to its end and checks the bottom row against what TweetHandler kept,
+//custom glyph cells have to hold the same CGRAM bitmap every time. also counts how often the CGRAM slot cache had to load a glyph,
+//and checks the connecting animation draws the logo pieces the boot animation left on the lcd
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../TweetHandler.h"
+
+extern TweetHandler twt;
+
+static const char *corpus[] = {
+    "Caf\xc3\xa9 au lait et cr\xc3\xa8me br\xc3\xbbl\xc3\xa9" "e \xc3\xa0 c\xc3\xb4t\xc3\xa9 de la gare\xe2\x80\xa6 tr\xc3\xa8s bon! \xe2\x9d\xa4\xef\xb8\x8f",
+    "\xe2\x80\x9cSmart quotes\xe2\x80\x9d and \xe2\x80\x98single ones\xe2\x80\x99 \xe2\x80\x94 plus an en\xe2\x80\x93" "dash and a bullet \xe2\x80\xa2 here",
+    "\xc3\x9c" "ber sch\xc3\xb6n: Gr\xc3\xb6\xc3\x9f" "e, \xc3\x9c" "bung, M\xc3\xa4" "dchen & S\xc3\xb6hne, 20\xc2\xb0" "C drau\xc3\x9f" "en \xe2\x98\x80\xef\xb8\x8f",
+    "New release \xf0\x9f\x8e\x89\xf0\x9f\x8e\x89 fixes the crash on startup \xf0\x9f\x98\x80 thanks everyone \xf0\x9f\x91\x8d\xf0\x9f\x8f\xbd",
+    "Paths like C:\\tmp\\log and ~/.config finally show up right on the display",
+    "Price drop: was \xe2\x82\xac" "49.99, now \xe2\x82\xac" "39.99 \xe2\x80\xa6 only today! \xe2\x99\xa5 \xe2\x98\xba",
+    "Ma\xc3\xb1" "ana vamos a la playa con mis ni\xc3\xb1os, \xc2\xbfvienes? \xc2\xa1Qu\xc3\xa9 bien!",
+    "Plain ascii tweet for comparison, nothing special in this one at all.",
+    "\xc3\xa9\xc3\xa8\xc3\xa0\xc3\xa7\xe2\x82\xac\xe2\x80\xa6\xe2\x99\xa5\xe2\x98\xba and then a few more words \\~ come after all of those",
+};
+#define CORPUS (sizeof(corpus) / sizeof(corpus[0]))
+
+static uint8_t glyphSeen[GLYPHCOUNT][8];                                        //bitmap each glyph id showed up with the first time
+static bool glyphKnown[GLYPHCOUNT] = {false};
+static unsigned long wrongGlyphs = 0;
+static const uint8_t logoCells[6][2] = {{1, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}, {3, 1}};   //col, row of each logo piece, boot and connecting alike
+static uint8_t logoSeen[6][8];                                                  //bitmaps the boot logo showed
+static bool logoKnown = false;
+static unsigned long logoChecks = 0;
+static unsigned long wrongLogo = 0;
+
+static void onLine(uint64_t atUs, const char *line) {                           //every '`' handshake request is a chance to look at the animation
+    if(strcmp(line, "`") != 0) {
+        return;
+    }
+    for(int i = 0; i < 6; i++) {
+        uint8_t d = simLcdRow(logoCells[i][1])[logoCells[i][0]];
+        if(d >= 8) {                                                            //a blank cell between animation frames
+            continue;
+        }
+        if(!logoKnown) {                                                        //the first request comes right after the boot logo
+            memcpy(logoSeen[i], simLcdGlyph(d), 8);
+            continue;
+        }
+        logoChecks++;
+        if(memcmp(logoSeen[i], simLcdGlyph(d), 8) != 0) {
+            wrongLogo++;
+        }
+    }
+    logoKnown = true;
+}
+
+static bool rowShows(const char *kept) {                                        //true if the bottom row of the lcd shows these 16 kept chars
+    const char *row = simLcdRow(1);
+    for(int c = 0; c < 16; c++) {
+        uint8_t k = kept[c];
+        uint8_t d = row[c];
+        if(k >= GLYPHFIRST && k < GLYPHFIRST + GLYPHCOUNT) {
+            if(d >= 8) {
+                return false;
+            }
+        }
+        else if(k != d) {
+            return false;
+        }
+    }
+    for(int c = 0; c < 16; c++) {                                               //it's there, now check the glyphs are the right ones
+        uint8_t k = kept[c];
+        if(k >= GLYPHFIRST && k < GLYPHFIRST + GLYPHCOUNT) {
+            const uint8_t *bitmap = simLcdGlyph(row[c]);
+            if(!glyphKnown[k - GLYPHFIRST]) {
+                memcpy(glyphSeen[k - GLYPHFIRST], bitmap, 8);
+                glyphKnown[k - GLYPHFIRST] = true;
+            }
+            else if(memcmp(glyphSeen[k - GLYPHFIRST], bitmap, 8) != 0) {
+                wrongGlyphs++;
+            }
+        }
+    }
+    return true;
+}
+
+static unsigned long glyphDraws(const char *kept, unsigned int length) {        //glyph cells drawn while scrolling through it, one per window that has them
+    unsigned int windows = length > 16 ? length - 15 : 1;
+    unsigned long draws = 0;
+    for(unsigned int w = 0; w < windows; w++) {
+        for(unsigned int c = w; c < w + 16; c++) {
+            if((uint8_t)kept[c] >= GLYPHFIRST && (uint8_t)kept[c] < GLYPHFIRST + GLYPHCOUNT) {
+                draws++;
+            }
+        }
+    }
+    return draws;
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, 40);                                                 //20ms per scroll step
+    simHostOnLine(onLine);
+    simHostAlive(false);                                                        //keeps the connecting animation going a few frames
+    simHostAliveAt(8000000, true);
+    setup();
+    simHostOnLine(NULL);
+    printf("TwiScn connecting animation: %lu logo cells checked, wrong %lu\n", logoChecks, wrongLogo);
+    simHostTransfer(simMicros(), "$f00100");                                    //short read time, the scrolling is what's being checked
+
+    printf("TwiScn utf-8 tweets on the lcd, %u samples\n", (unsigned int)CORPUS);
+    printf("  %-4s %8s %8s %12s %12s %10s\n", "", "bytes", "cells", "glyph draws", "CGRAM loads", "shown");
+    unsigned long totalDraws = 0;
+    unsigned long totalLoads = 0;
+    unsigned int shownRight = 0;
+    for(unsigned int i = 0; i < CORPUS; i++) {
+        char before[300];
+        strcpy(before, twt.getTweet(true));
+        unsigned long loads = simStats.cgramLoads;                              //the previous tweet is at its end, nothing more gets loaded for it
+        simHostFrame(simMicros(), "@TwiScnBench", corpus[i], false);
+        uint64_t limit = simMicros() + 5000000;
+        while(strcmp(twt.getTweet(true), before) == 0 && simMicros() < limit) { //wait for it to come up
+            loop();
+        }
+        const char *kept = twt.getTweet(true);
+        unsigned int length = twt.getTweetLength(true);
+        const char *tail = kept + (length > 16 ? length - 16 : 0);
+        limit = simMicros() + 30000000;
+        bool shown = false;
+        while(!shown && simMicros() < limit) {
+            loop();
+            shown = rowShows(tail);
+        }
+        loads = simStats.cgramLoads - loads;
+        unsigned long draws = glyphDraws(kept, length);
+        totalDraws += draws;
+        totalLoads += loads;
+        shownRight += shown;
+        printf("  #%-3u %8u %8u %12lu %12lu %10s\n", i, (unsigned int)strlen(corpus[i]), length, draws, loads, shown ? "yes" : "NO");
+    }
+    printf("glyph cells drawn %lu, CGRAM loads %lu (%.1f%% served from the slot cache), wrong glyphs %lu, tweets scrolled to the end right %u/%u\n",
+           totalDraws, totalLoads, totalDraws ? 100.0 * (totalDraws - totalLoads) / totalDraws : 0.0, wrongGlyphs, shownRight, (unsigned int)CORPUS);
+    return wrongLogo || !logoChecks || wrongGlyphs || shownRight != CORPUS;     //non-zero if any check failed
+}
@@ -0,0 +1,80 @@
+//host loss: how long the device takes to notice the USB bus going away with different 'k' start of frame timeouts,
+//and the host program dying with keepalives on. then a host that doesn't send keepalives at all: checks the bus
+//staying up never trips a false alarm, counts the packets it saves, and times the warm reconnect when the bus is back
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+
+static bool noticeUp() {
+    return strncmp(simLcdRow(0), "Host has been", 13) == 0;
+}
+
+static bool tweetUp() {
+    return simLcdOn() && strcmp(simLcdRow(0), "lossbench       ") == 0;
+}
+
+static bool printMs(const char *what, bool happened, uint64_t fromUs) {         //passes happened through
+    if(happened) {
+        printf("  %-36s %10.1f\n", what, (simMicros() - fromUs) / 1000.0);
+    }
+    else {
+        printf("  %-36s %10s\n", what, "never");
+    }
+    return happened;
+}
+
+static bool loss(const char *what, const char *option, bool bus) {              //sets the timeouts, then drops the bus or just the host program, false if nothing noticed
+    simHostTransfer(simMicros(), option);
+    simRunFor(3000);
+    uint64_t start = simMicros();
+    if(bus) {
+        simBusAlive(false);
+    }
+    else {
+        simHostAlive(false);
+    }
+    bool noticed = printMs(what, simRunUntil(noticeUp, 30000), start);
+    simBusAlive(true);
+    simHostAlive(true);
+    return simRunUntil(tweetUp, 15000) && noticed;
+}
+
+int main() {
+    simHostKeepAlive(1000);                                                     //a host that doesn't know 'k' yet
+    setup();
+    simHostTransfer(simMicros(), "@lossbench");
+    simHostTransfer(simMicros() + 100000, "!carry on");
+    simRunFor(5000);
+
+    printf("TwiScn host loss, ms until the disconnect notice\n");
+    bool ok = true;
+    ok &= loss("bus gone, default timeouts", "$k010100", true);
+    ok &= loss("bus gone, sof 20ms", "$k010020", true);
+    ok &= loss("bus gone, sof 250ms", "$k010250", true);
+    ok &= loss("bus gone, sof 300ms (reads 255)", "$k010300", true);
+    ok &= loss("bus gone, sof off (keepalive 10s)", "$k010000", true);
+    ok &= loss("host program gone, keepalive 10s", "$k010100", false);
+    ok &= loss("host program gone, keepalive 2s", "$k002100", false);
+
+    printf("without keepalives ($k000100)\n");
+    simHostTransfer(simMicros(), "$k000100");
+    simRunFor(1000);
+    simHostKeepAlive(0);
+    simResetStats();
+    bool falseAlarm = simRunUntil(noticeUp, 60000);
+    printf("  %-36s %10s\n", "false alarm in a quiet minute", falseAlarm ? "yes" : "no");
+    printf("  %-36s %10lu\n", "packets that minute (keepalives: 60)", simStats.packetsIn);
+    uint64_t start = simMicros();
+    simBusAlive(false);
+    ok &= printMs("bus gone", simRunUntil(noticeUp, 30000), start);
+    simRunFor(5000);
+    start = simMicros();
+    simBusAlive(true);
+    ok &= printMs("bus back, tweet shown", simRunUntil(tweetUp, 15000), start);
+    simRunFor(3000);
+    start = simMicros();
+    simHostAlive(false);                                                        //the bus stays up and no keepalives are expected, so nothing notices
+    ok &= !printMs("host program gone, bus still up", simRunUntil(noticeUp, 30000), start);
+    return !ok || falseAlarm;                                                   //non-zero if any check failed
+}
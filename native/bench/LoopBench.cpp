@@ -0,0 +1,133 @@
+//loop() benchmark for the native build: runs the firmware against the simulated host while tweets scroll
+//times are virtual AVR microseconds (see Sim.h), host ns is what the code itself costs on this machine
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "Sim.h"
+#include "../../Comms.h"
+#include "../../IO.h"
+#include "../../LCDControl.h"
+#include "../../Scheduler.h"
+
+extern Comms comms;
+extern LCDControl lcd;
+extern Scheduler sched;
+
+struct Timing {
+    const char *name;
+    unsigned long calls;
+    uint64_t totalUs;
+    uint64_t worstUs;
+    uint64_t hostNs;
+};
+
+static uint64_t hostNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void timed(Timing &t, void (*fn)()) {                                    //runs fn and charges its cost to t, time the cpu spent idle doesn't count
+    uint64_t v = simMicros();
+    uint64_t s = simStats.sleepUs;
+    uint64_t h = hostNs();
+    fn();
+    uint64_t dv = simMicros() - v - (simStats.sleepUs - s);
+    t.hostNs += hostNs() - h;
+    t.totalUs += dv;
+    if(dv > t.worstUs) {
+        t.worstUs = dv;
+    }
+    t.calls++;
+}
+
+static void printTiming(const Timing &t) {
+    printf("  %-12s %10lu %10.1f %10llu %10.1f\n", t.name, t.calls,
+           t.calls ? (double)t.totalUs / t.calls : 0.0, (unsigned long long)t.worstUs,
+           t.calls ? (double)t.hostNs / t.calls : 0.0);
+}
+
+//==============================================================================
+
+static char tweetTransfer[300];
+static uint64_t nextTweet = 0;
+
+static void feedHost() {                                                        //pushes a new 280 character tweet every 40 seconds
+    if(simMicros() < nextTweet) {
+        return;
+    }
+    static const char words[] = "the quick brown fox jumps over the lazy dog ";
+    static int tweetCount = 0;
+    tweetCount++;
+    int n = snprintf(tweetTransfer, sizeof(tweetTransfer), "!#%d ", tweetCount);
+    for(int i = n; i < 281; i++) {
+        tweetTransfer[i] = words[(i - n) % (sizeof(words) - 1)];
+    }
+    tweetTransfer[281] = 0;
+    uint64_t at = simHostTransfer(simMicros(), "@TwiScnBench");
+    simHostTransfer(at, tweetTransfer);
+    nextTweet = simMicros() + 40000000ULL;
+}
+
+static void stepReadComms() { comms.readComms(); }
+static void stepUpdateLCD() { lcd.updateLCD(); }
+static void stepRunDue() { sched.runDue(); }
+
+static const char *taskNames[] = {"anim", "buttons", "pot", "rainbow", "scroll", "blink", "checkAlive", "checkSleep", "save", "log"};
+
+int main(int argc, char **argv) {
+    unsigned long seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : 120;
+    uint64_t runUs = (uint64_t)seconds * 1000000;
+
+    simHostKeepAlive(1000);                                                     //the host program sends '%' every second
+    simSetAnalog(SPEEDPIN, 200);                                                //100ms per scroll step
+    setup();
+    uint64_t at = simHostTransfer(simMicros(), "$e100020");                     //rainbow on, 20ms steps
+    simHostTransfer(at, "$d1100255000000");                                     //tweet blink on, red
+    printf("TwiScn loop() benchmark, %lu s of virtual time per run, boot took %.1f ms\n\n",
+           seconds, simMicros() / 1000.0);
+
+    //run 1: loop() exactly as the firmware runs it
+    Timing whole = {"loop()", 0, 0, 0, 0};
+    simResetStats();
+    uint64_t end = simMicros() + runUs;
+    while(simMicros() < end) {
+        feedHost();
+        timed(whole, loop);
+    }
+    SimStats stats = simStats;
+    printf("loop(): %lu iterations, %.0f iterations/s, mean %.1f us, worst %llu us, host %.1f ns/iteration\n",
+           whole.calls, whole.calls / (double)seconds, (double)whole.totalUs / whole.calls,
+           (unsigned long long)whole.worstUs, (double)whole.hostNs / whole.calls);
+    printf("cpu awake %.1f%% of the time, idled %.0f times/s\n", 100.0 - 100.0 * stats.sleepUs / runUs, stats.sleeps / (double)seconds);
+    printf("LCD bus: %.1f commands/s, %.1f writes/s; usbPoll: worst gap %llu us; packets in %lu, reports out %lu\n\n",
+           stats.lcdCommands / (double)seconds, stats.lcdWrites / (double)seconds,
+           (unsigned long long)stats.maxPollGapUs, stats.packetsIn, stats.reportsOut);
+
+    //run 2: the same sequence as loop(), one part at a time (keep in step with main.cpp)
+    Timing steps[] = {{"readComms", 0, 0, 0, 0}, {"updateLCD", 0, 0, 0, 0}, {"runDue", 0, 0, 0, 0}};
+    void (*fns[])() = {stepReadComms, stepUpdateLCD, stepRunDue};
+    sched.resetStats();
+    end = simMicros() + runUs;
+    while(simMicros() < end) {
+        feedHost();
+        for(unsigned int i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+            timed(steps[i], fns[i]);
+        }
+    }
+    printf("  %-12s %10s %10s %10s %10s\n", "section", "calls", "mean us", "worst us", "host ns");
+    for(unsigned int i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        printTiming(steps[i]);
+    }
+
+    //what the scheduler saw during run 2, task times are virtual us as measured by the firmware itself
+    printf("\nscheduler: %lu passes, %.1f%% found nothing due\n", sched.getPasses(),
+           100.0 * sched.getIdlePasses() / sched.getPasses());
+    printf("  %-12s %10s %10s %10s %10s\n", "task", "runs", "runs/s", "mean us", "worst us");
+    for(byte i = 0; i < sched.getTaskCount(); i++) {
+        const Task &t = sched.getTask(i);
+        printf("  %-12s %10lu %10.1f %10.1f %10lu\n", i < sizeof(taskNames) / sizeof(taskNames[0]) ? taskNames[i] : "?",
+               t.runs, t.runs / (double)seconds, t.runs ? (double)t.totalMicros / t.runs : 0.0, t.maxMicros);
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+//applying a full option profile: one ascii transfer per option against a single binary transfer
+//counts packets, heap allocations and the virtual time from the first packet until every option is applied, then checks
+//binary transfers whose packets start with the bytes that mean something at a packet start
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../Comms.h"
+#include "../../Options.h"
+
+extern Comms comms;
+extern Options opt;
+
+static const char *asciiProfile[] = {"$b200", "$c000150255", "$d1100255000000", "$e100020", "$f03000", "$g0", "$h1", "$s0"};
+
+//the same profile as binary records: type letter plus little endian payload
+static const unsigned char binaryRecords[] = {
+    'b', 200,
+    'c', 0, 150, 255,
+    'd', 1, 100, 255, 0, 0,
+    'e', 1, 20, 0,
+    'f', 3000 & 0xFF, 3000 >> 8,
+    'g', 0,
+    'h', 1,
+    's', 0};
+
+static unsigned int stuff(const unsigned char *in, unsigned int length, char *out) {   //COBS encodes in, like the host program does
+    unsigned int codeAt = 0;
+    unsigned int o = 1;
+    unsigned char code = 1;
+    for(unsigned int i = 0; i < length; i++) {
+        if(in[i] == 0) {
+            out[codeAt] = code;
+            codeAt = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if(++code == 0xFF) {
+            out[codeAt] = code;
+            codeAt = o++;
+            code = 1;
+        }
+    }
+    out[codeAt] = code;
+    return o;
+}
+
+struct Result {
+    unsigned long packets;
+    unsigned long allocs;
+    uint64_t tookUs;
+};
+
+static Result apply(const char **transfers, int count) {                        //sends the transfers back to back and runs loop() until all are handled
+    uint64_t start = simMicros();
+    uint64_t at = start;
+    for(int i = 0; i < count; i++) {
+        at = simHostTransfer(at, transfers[i]);
+    }
+    simResetStats();                                                            //after queueing, the host model allocates too
+    unsigned long packets = 0;
+    for(int i = 0; i < count; i++) {
+        packets += (strlen(transfers[i]) + 30) / 31 + 1;
+    }
+    while(simStats.packetsIn < packets) {
+        loop();
+    }
+    Result r = {packets, simStats.heapAllocs, simMicros() - start};
+    return r;
+}
+
+static bool profileApplied() {
+    byte *c = opt.getCol();
+    return opt.getBrightness() == 200 && c[0] == 0 && c[1] == 150 && c[2] == 255 && opt.getBlink() &&
+           opt.getBlinkSpd() == 100 && opt.getRainbow() && opt.getRainSpd() == 20 && opt.getReadTime() == 3000 &&
+           opt.getScroll() && !opt.getSleep();
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    setup();
+
+    opt.defaults();
+    Result ascii = apply(asciiProfile, sizeof(asciiProfile) / sizeof(asciiProfile[0]));
+    bool asciiOk = profileApplied();
+
+    char binary[64];
+    binary[0] = '$';
+    binary[1] = (char)OPTBINARY;
+    unsigned int length = 2 + stuff(binaryRecords, sizeof(binaryRecords), binary + 2);
+    binary[length] = 0;
+    const char *binaryProfile[] = {binary};
+    opt.defaults();
+    Result bin = apply(binaryProfile, 1);
+    bool binaryOk = profileApplied();
+
+    printf("TwiScn full option profile (8 options)\n");
+    printf("  %-8s %10s %10s %10s %8s\n", "format", "packets", "allocs", "took ms", "applied");
+    printf("  %-8s %10lu %10lu %10.1f %8s\n", "ascii", ascii.packets, ascii.allocs, ascii.tookUs / 1000.0, asciiOk ? "yes" : "NO");
+    printf("  %-8s %10lu %10lu %10.1f %8s\n", "binary", bin.packets, bin.allocs, bin.tookUs / 1000.0, binaryOk ? "yes" : "NO");
+    printf("  binary transfer is %u bytes\n", length);
+
+    //32 bytes, so the host splits it 30 and 2 instead of leaving a lone last byte. the second packet is the end of the
+    //last color record, all '=', '%', '*' or '&'
+    const char fills[] = "=%*&";
+    for(const char *fill = fills; *fill; fill++) {
+        unsigned char records[29] = {'f', 3000 & 0xFF, 3000 >> 8, 'b', 200};
+        for(int i = 5; i < 29; i += 4) {
+            records[i] = 'c';
+            memset(records + i + 1, i == 25 ? *fill : 1, 3);
+        }
+        char edge[64] = {'$', (char)OPTBINARY};
+        unsigned int edgeLength = 2 + stuff(records, sizeof(records), edge + 2);
+        edge[edgeLength] = 0;
+        const char *edgeProfile[] = {edge};
+        opt.defaults();
+        apply(edgeProfile, 1);
+        byte *c = opt.getCol();
+        bool applied = opt.getReadTime() == 3000 && opt.getBrightness() == 200 && c[0] == (byte)*fill && c[1] == (byte)*fill && c[2] == (byte)*fill;
+        printf("  packets starting with '%c': %s\n", *fill, applied ? "applied" : "NOT applied");
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+//packed tweet text: compression ratio of the TextPack dictionary on a corpus of sample tweets, and what
+//unpacking costs the device. every tweet goes out as a plain '*' frame and as a packed '&' frame
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Sim.h"
+#include "../../TweetHandler.h"
+#include "../../Comms.h"
+
+extern TweetHandler twt;
+extern Comms comms;
+
+static const char *corpus[] = {
+    "Just finished the first prototype of the new LCD board, it actually works! Pictures coming soon",
+    "RT @arduino: Check out this amazing project that turns an old phone into a weather station http://t.co/x7Yq2LmPz",
+    "Good morning everyone, coffee is ready and the sun is out. Have a great day!",
+    "I can't believe how fast this year is going. Already planning for the summer holidays",
+    "New blog post: How to build a USB device with V-USB and an ATmega328p https://t.co/4fGhT2kQa",
+    "Thanks to everyone who came out to the meetup tonight, it was great to see so many new faces",
+    "Is there anything better than a quiet Sunday afternoon with a good book? I don't think so",
+    "The new update is out now with bug fixes and some performance improvements. Let us know what you think",
+    "We are hiring! Looking for an embedded developer who loves hardware as much as we do http://t.co/jobs123",
+    "Watching the game tonight with friends, let's go team!!",
+    "Reminder: the workshop starts at 10am tomorrow, bring your laptop and a USB cable",
+    "Just saw the most beautiful sunset on the way home from work",
+    "Does anyone know why my code compiles fine but the board keeps resetting? Driving me crazy",
+    "Happy birthday to the best sister in the world, love you so much",
+    "Our store will be closed on Monday for the holiday, we will be back on Tuesday with new stock",
+    "Who else is excited for the new season of their favourite show? No spoilers please",
+    "Finally got the scrolling text working on the display, only took three weekends",
+    "Breaking: heavy rain expected this evening across the region, please drive carefully",
+    "I think the best part of making things is when they finally work the way you imagined",
+    "Download the latest version of the app for free on iOS and Android http://t.co/app2go",
+    "Thank you for all the kind messages today, it means a lot to me and the whole team",
+    "Weekend project: soldering together a little clock with an RTC and a tiny OLED screen",
+    "What are you reading this week? Looking for some recommendations",
+    "Traffic is terrible this morning, going to be late again",
+    "Our thoughts are with everyone affected by the storm, stay safe out there",
+    "Just updated the firmware and now everything is faster, this is why you should always profile first",
+    "This is the kind of weather that makes you want to stay in bed all day",
+    "Can't wait to share what we have been working on for the last few months. Stay tuned!",
+    "RT @hackaday: A tiny Twitter screen that sits on your desk and shows your latest mentions http://t.co/hd8Kq",
+    "Live now: join us for a question and answer session about open source hardware",
+    "Dinner tonight was amazing, thank you to the chef for such a great meal",
+    "Remember to drink water and take a break from the screen every once in a while",
+    "Big news coming on Friday, you will not want to miss it",
+    "The conference schedule has been posted, there are some really interesting talks this year",
+    "We just passed one thousand followers, thank you all for the support!",
+    "Is it just me or does every meeting that could have been an email take twice as long?",
+    "Working late again tonight, but the new feature is almost done",
+    "Please retweet to help us find our lost dog, last seen near the park on Main Street",
+    "If you have not tried the new coffee place downtown you are missing out",
+    "Sometimes the simplest solution really is the best one",
+    "Excited to announce that our kit is now available to order from our website http://t.co/shop42",
+    "Early morning run done, now time for breakfast and a long day of work",
+    "There is nothing like the feeling of fixing a bug that has been bugging you for days",
+    "How do you all keep your workbench organized? Mine is a complete mess right now",
+    "Last chance to enter the giveaway, winners will be announced tomorrow",
+    "The library was packed today, everyone studying for final exams",
+    "Learning something new every day, today it was how interrupts work on AVR chips",
+    "Just a reminder that you are doing better than you think you are",
+    "Thanks for the follow! Let me know if you have any questions about the project",
+    "Tonight's forecast: clear skies and a good chance to see the meteor shower",
+    "Caf\xc3\xa9 con leche \xe2\x98\x95 before the 8am lecture, na\xc3\xafve of me to think I'd be awake for it",
+};
+#define CORPUS (sizeof(corpus) / sizeof(corpus[0]))
+
+static unsigned long rejects = 0;
+
+static void onLine(uint64_t atUs, const char *line) {                           //counts the device refusing frames
+    if(line[0] == '*') {
+        rejects++;
+    }
+}
+
+static double nowNs() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+struct Result {
+    unsigned long packets;
+    uint64_t us;                                                                //virtual time, first packet until queued
+    double readNs;                                                              //host cpu time inside readComms() calls that read a packet
+    unsigned long wrong;                                                        //tweets that came out different from what went in
+};
+
+static char kept[CORPUS][300];                                                   //what each plain frame left in the tweet queue, packed ones have to match it
+
+static void deliver(unsigned int i, bool packed, Result &r) {
+    char frame[SIM_FRAME_LEN];
+    char before[300];
+    unsigned int length = simMakeFrame(frame, "@TwiScnBench", corpus[i], packed);
+    while(twt.nextTweet()) {                                                    //skip ahead of the lcd
+    }
+    strcpy(before, twt.getTweet(true));                                         //neighbouring tweets differ, so a change means it arrived
+    uint64_t start = simMicros();
+    simHostPackets(start, frame);
+    r.packets += (length + SIM_PACKET_LEN - 1) / SIM_PACKET_LEN;
+    while(!twt.getPending() && strcmp(twt.getTweet(true), before) == 0 && simMicros() - start < 5000000) {
+        unsigned long packetsIn = simStats.packetsIn;
+        double t = nowNs();
+        comms.readComms();
+        t = nowNs() - t;
+        if(simStats.packetsIn != packetsIn) {                                   //only the calls that handled a packet, idle polling would drown it out
+            r.readNs += t;
+        }
+    }
+    r.us += simMicros() - start;
+    twt.nextTweet();
+    if(!packed) {
+        strcpy(kept[i], twt.getTweet(true));
+    }
+    if(strcmp(twt.getTweet(true), kept[i]) != 0 || strcmp(twt.getUser(true), "@TwiScnBench") != 0) {
+        r.wrong++;
+    }
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    simHostKeepAlive(1000);
+    simHostOnLine(onLine);
+    setup();
+
+    unsigned long chars = 0;
+    unsigned long packedBytes = 0;
+    unsigned int worst = 0;
+    for(unsigned int i = 0; i < CORPUS; i++) {
+        char body[600];
+        unsigned int len = strlen(corpus[i]);
+        unsigned int packedLen = simPack(body, corpus[i]);
+        chars += len;
+        packedBytes += packedLen;
+        if(packedLen * 100 / len > worst) {
+            worst = packedLen * 100 / len;
+        }
+    }
+
+    Result plain = {0, 0, 0, 0};
+    Result packed = {0, 0, 0, 0};
+    for(int round = 0; round < rounds; round++) {
+        for(unsigned int i = 0; i < CORPUS; i++) {                             //a whole pass each, back to back copies of one tweet can't be told apart
+            deliver(i, false, plain);
+        }
+        for(unsigned int i = 0; i < CORPUS; i++) {
+            deliver(i, true, packed);
+        }
+    }
+    double n = (double)rounds * CORPUS;
+
+    printf("TwiScn packed tweet text, %u sample tweets, %lu characters\n", (unsigned int)CORPUS, chars);
+    printf("  packed to %lu bytes, ratio %.3f (worst tweet %u%%)\n", packedBytes, (double)packedBytes / chars, worst);
+    printf("  %-10s %14s %22s %18s\n", "transfer", "packets/tweet", "first packet to queue ms", "packet ns/tweet");
+    printf("  %-10s %14.2f %22.2f %18.2f\n", "* frame", plain.packets / n, plain.us / 1000.0 / n, plain.readNs / n);
+    printf("  %-10s %14.2f %22.2f %18.2f\n", "& frame", packed.packets / n, packed.us / 1000.0 / n, packed.readNs / n);
+    printf("unpacking: %.0f ns per packed byte on this host (plain frames %.0f), packed tweets that differ from the plain ones: %lu, frames refused: %lu\n",
+           packed.readNs / (packedBytes * rounds), plain.readNs / (chars * rounds), packed.wrong, rejects);
+    return 0;
+}
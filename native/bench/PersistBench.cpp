@@ -0,0 +1,82 @@
+//saved options: what a reconnect or power cycle comes back with, how many EEPROM writes the host's option traffic
+//costs, and that a damaged record falls back to the defaults. prepare() stands in for the power cycle
+#include <Arduino.h>
+#include <stdio.h>
+#include "Sim.h"
+#include "../../Options.h"
+#include "../../Comms.h"
+
+extern Options opt;
+extern Comms comms;
+void prepare();
+
+static const char *profile[] = {"$b180", "$c255040000", "$d1050000255000", "$e000020", "$f02500"};
+#define PROFILECOUNT (sizeof(profile) / sizeof(profile[0]))
+
+static void send(const char **options, unsigned int count) {                    //one option per transfer, like the host program does it
+    uint64_t at = simMicros();
+    for(unsigned int i = 0; i < count; i++) {
+        at = simHostTransfer(at, options[i]);
+    }
+}
+
+static bool isProfile() {                                                       //the options profile[] sets, brightness as the boot fade target
+    byte *c = opt.getCol();
+    byte *b = opt.getBlinkCol();
+    return opt.getBootBrightness() == 180 && c[0] == 255 && c[1] == 40 && c[2] == 0 && opt.getBlink() &&
+           opt.getBlinkSpd() == 50 && b[0] == 0 && b[1] == 255 && b[2] == 0 && !opt.getRainbow() &&
+           opt.getRainSpd() == 20 && opt.getReadTime() == 2500;
+}
+
+static void writes(const char *what, unsigned long ms) {                        //runs for ms and reports the EEPROM writes meanwhile
+    unsigned long before = simStats.eepromWrites;
+    uint64_t start = simMicros();
+    simRunFor(ms);
+    printf("  %-34s %8lu %14.1f\n", what, simStats.eepromWrites - before, (simMicros() - start) / 1000.0);
+}
+
+static void powerCycle(const char *what) {                                      //boot animation and handshake again, without the host sending any options
+    comms.setConnected(false);
+    uint64_t start = simMicros();
+    prepare();
+    printf("  %-34s %8s %10d %14.1f\n", what, isProfile() ? "saved" : "defaults", opt.getBrightness(), (simMicros() - start) / 1000.0);
+    simRunFor(1000);
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    setup();
+    simRunFor(1000);
+
+    printf("TwiScn saved options, %u option transfers in the profile, %d byte record\n", (unsigned int)PROFILECOUNT, OPTRECORD);
+    printf("  %-34s %8s %14s\n", "host sends", "writes", "over ms");
+    send(profile, PROFILECOUNT);
+    writes("the profile, first time", 4000);
+    send(profile, PROFILECOUNT);
+    writes("the same profile again", 4000);
+    const char *dim[] = {"$b120", "$b100", "$b080"};                            //dragging a brightness slider
+    send(dim, 3);
+    writes("three brightness steps", 4000);
+    send(profile, 1);
+    writes("brightness back", 4000);
+    const char *rainbow[] = {"$e100005"};
+    send(rainbow, 1);
+    writes("rainbow on, then 60s of it", 60000);
+    const char *noRainbow[] = {"$e000020"};
+    send(noRainbow, 1);
+    writes("rainbow off", 4000);
+    send(profile + 1, 1);
+    writes("color again", 4000);
+
+    printf("  %-34s %8s %10s %14s\n", "power cycle", "options", "brightness", "prepare() ms");
+    powerCycle("record intact");
+    simEepromPoke(OPTRECORDADDR + 5, 0x42);                                     //a byte the crc doesn't agree with
+    powerCycle("record damaged");
+
+    unsigned long worst = 0;
+    for(int i = 0; i < OPTRECORD; i++) {
+        worst = simEepromWear(OPTRECORDADDR + i) > worst ? simEepromWear(OPTRECORDADDR + i) : worst;
+    }
+    printf("most writes to one cell: %lu\n", worst);
+    return 0;
+}
@@ -0,0 +1,83 @@
+//speed pot filtering: how often ADC noise changes the scroll speed with the knob standing still, and how quickly a turn
+//of the knob comes through. the unfiltered column is what reading analogRead(SPEEDPIN) / 2 every pot task would give
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Sim.h"
+#include "../../IO.h"
+
+extern int lastSpeed;                                                           //what the pot task last gave the lcd
+
+#define NOISE 3                                                                 //ADC counts of noise either way, about what a long pot lead picks up
+#define POTMS 50                                                                //how often the pot task looks, POTPERIOD in main.cpp
+
+struct Still {
+    unsigned long changes;                                                      //speed changes the lcd got
+    int low;                                                                    //range of speeds it saw
+    int high;
+};
+
+static Still holdStill(unsigned long ms, bool unfiltered) {                     //knob stays put at 300 for ms
+    Still s = {0, 0, 0};
+    simSetAnalog(SPEEDPIN, 300);
+    uint64_t end = simMicros() + (uint64_t)ms * 1000;
+    uint64_t nextLook = simMicros();
+    int last = unfiltered ? analogRead(SPEEDPIN) / 2 : lastSpeed;
+    s.low = s.high = last;
+    while(simMicros() < end) {
+        loop();
+        int now = lastSpeed;
+        if(unfiltered) {
+            if(simMicros() < nextLook) {
+                continue;
+            }
+            nextLook += POTMS * 1000;
+            now = analogRead(SPEEDPIN) / 2;
+        }
+        if(now != last) {
+            s.changes++;
+            last = now;
+            s.low = now < s.low ? now : s.low;
+            s.high = now > s.high ? now : s.high;
+        }
+    }
+    return s;
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    simSetAnalogNoise(NOISE);
+    setup();
+    Still settle = holdStill(1000, false);
+    (void)settle;
+
+    printf("TwiScn speed pot, +-%d counts of ADC noise, pot task every %dms\n", NOISE, POTMS);
+    printf("  %-12s %14s %14s\n", "reading", "changes/10s", "speed range");
+    Still raw = holdStill(10000, true);
+    printf("  %-12s %14lu %9d-%-4d\n", "unfiltered", raw.changes, raw.low, raw.high);
+    simResetStats();
+    Still filtered = holdStill(10000, false);
+    printf("  %-12s %14lu %9d-%-4d\n", "filtered", filtered.changes, filtered.low, filtered.high);
+    printf("ADC interrupts: %.0f/s, blocking analogRead() calls from the firmware: %lu\n",
+           simStats.adcIsrs / 10.0, simStats.analogReads);
+
+    //turn the knob from 300 to 800 over half a second, then let go
+    uint64_t start = simMicros();
+    uint64_t turned = start + 500000;
+    uint64_t lastChange = start;
+    unsigned long changes = 0;
+    int last = lastSpeed;
+    while(simMicros() < turned + 2000000) {
+        uint64_t now = simMicros();
+        simSetAnalog(SPEEDPIN, now < turned ? 300 + (int)((now - start) * 500 / 500000) : 800);
+        loop();
+        if(lastSpeed != last) {
+            last = lastSpeed;
+            lastChange = simMicros();
+            changes++;
+        }
+    }
+    printf("knob turn 300 -> 800 in 500ms: %lu speed changes, settled %.0fms after the knob stopped, at %d (knob says %d)\n",
+           changes, lastChange > turned ? (lastChange - turned) / 1000.0 : 0.0, lastSpeed, 800 / 2);
+    return 0;
+}
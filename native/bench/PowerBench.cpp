@@ -0,0 +1,41 @@
+//cpu duty cycle: how much of the time the firmware keeps the cpu running while scrolling, in standby and with the host gone
+//loop() idles the cpu until the next interrupt whenever it finds nothing to do, the rest counts as awake
+#include <Arduino.h>
+#include <stdio.h>
+#include "Sim.h"
+#include "../../IO.h"
+
+static void phase(const char *name, unsigned long ms) {                         //runs loop() for ms and prints the duty cycle
+    simResetStats();
+    uint64_t start = simMicros();
+    unsigned long loops = 0;
+    uint64_t end = start + (uint64_t)ms * 1000;
+    while(simMicros() < end) {
+        loop();
+        loops++;
+    }
+    double took = simMicros() - start;
+    printf("  %-12s %10.1f%% %12.0f %12.0f %12.1f\n", name, 100.0 - 100.0 * simStats.sleepUs / took,
+           simStats.sleeps / (took / 1e6), loops / (took / 1e6), simStats.maxPollGapUs / 1000.0);
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, 200);                                                //100ms per scroll step
+    setup();
+    uint64_t at = simHostTransfer(simMicros(), "@TwiScnBench");
+    simHostTransfer(at, "!the quick brown fox jumps over the lazy dog, then it does it all over again, and again");
+
+    printf("TwiScn cpu duty cycle\n");
+    printf("  %-12s %11s %12s %12s %12s\n", "phase", "awake", "idles/s", "loop()/s", "poll gap ms");
+    phase("scrolling", 20000);
+    simHostTransfer(simMicros(), "$s1");
+    phase("going off", 4000);                                                   //standby notice and the fade out
+    phase("standby", 60000);
+    simHostTransfer(simMicros(), "$s0");
+    phase("waking", 4000);
+    simHostAlive(false);
+    phase("host lost", 30000);                                                  //the disconnect notice, then the lcd goes off
+    phase("host gone", 60000);
+    return 0;
+}
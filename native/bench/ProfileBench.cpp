@@ -0,0 +1,82 @@
+//section profiler: runs tweets through with the rainbow and tweet blink on and prints the PROFILE() table, then
+//dumps it over the HID link with a '#' transfer and checks the host gets the same figures. virtual time only moves
+//for modelled hardware, so sections that just compute read 0us here, on the board they won't.
+//readComms() keeps running until the '#' transfer is in, so its row in the dump has a few more calls
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../Profiler.h"
+
+static ProfStats dumped[PROFSECTIONS];
+static int dumpedLines = 0;
+
+static void onLine(uint64_t atUs, const char *line) {                           //decodes a '#' line, see Comms.cpp
+    if(line[0] != '#' || line[1] < '0' || line[1] >= '0' + PROFSECTIONS) {
+        return;
+    }
+    const unsigned char *in = (const unsigned char *)line + 2;
+    static const int digits[] = {3, 2, 2, 2};
+    unsigned long value[4];
+    for(int f = 0; f < 4; f++) {
+        value[f] = 0;
+        for(int d = 0; d < digits[f]; d++) {
+            value[f] = (value[f] << 7) | (*in++ & 0x7F);
+        }
+    }
+    ProfStats &s = dumped[line[1] - '0'];
+    s.calls = value[0];
+    s.low = value[1];
+    s.high = value[2];
+    s.total = value[3] * value[0];                                              //only the mean comes over
+    dumpedLines++;
+}
+
+int main() {
+    simHostOnLine(onLine);
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, 80);
+    setup();
+    uint64_t at = simHostTransfer(simMicros(), "$d1050000255000");              //tweet blink on
+    simHostTransfer(at, "$e100005");                                            //rainbow on
+    simRunFor(1000);
+    profReset();
+
+    char text[TWEETSIZE + 1];
+    for(int i = 0; i < TWEETSIZE; i++) {
+        text[i] = 'a' + i % 26;
+    }
+    text[TWEETSIZE] = 0;
+    for(int i = 0; i < 6; i++) {
+        char user[8];
+        sprintf(user, "user%d", i);
+        simHostFrame(simMicros(), user, text + i * 40, false);                  //240 down to 40 chars
+        simRunFor(5000);
+    }
+    ProfStats kept[PROFSECTIONS];
+    memcpy(kept, profTable, sizeof(kept));
+    simHostTransfer(simMicros(), "#");
+    simRunFor(100);
+
+    printf("TwiScn section profile, 30s of tweets with the rainbow and tweet blink on\n");
+    printf("  %-10s %10s %10s %10s %10s %10s\n", "section", "calls", "min us", "max us", "mean us", "dump");
+    for(int i = 0; i < PROFSECTIONS; i++) {
+        char name[PROFNAMEWIDTH + 1];
+        memcpy_P(name, profNames + i * PROFNAMEWIDTH, PROFNAMEWIDTH);
+        name[PROFNAMEWIDTH] = 0;
+        ProfStats &s = kept[i];
+        unsigned long mean = s.calls ? s.total / s.calls : 0;
+        char dump[16];
+        if(dumped[i].calls == s.calls && dumped[i].low == s.low && dumped[i].high == s.high &&
+           (!s.calls || dumped[i].total / dumped[i].calls == mean)) {
+            strcpy(dump, "same");
+        }
+        else {
+            sprintf(dump, "%+ld calls", (long)(dumped[i].calls - s.calls));
+        }
+        printf("  %-10s %10lu %10u %10u %10lu %10s\n", name, s.calls, s.low, s.high, mean, dump);
+    }
+    printf("dump: %d lines, table empty after it: %s\n", dumpedLines, profTable[PROFCOMMS].calls < kept[PROFCOMMS].calls ? "yes" : "no");
+    return 0;
+}
@@ -0,0 +1,112 @@
+//a burst of tweets pushed back to back: checks that every one gets its turn on the lcd, in order, scrolled to the end
+//the host sends frames in order, and when the device refuses one with "*f" (queue full) it tries that one again a second later.
+//then an old '@'/'!' host overfills the queue, the '!' transfer that doesn't fit has to get the same "*f"
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../TweetHandler.h"
+
+extern TweetHandler twt;
+
+#define BURST 6
+
+static unsigned long refused = 0;
+static bool wasRefused = false;
+
+static void onLine(uint64_t atUs, const char *line) {
+    if(strcmp(line, "*f") == 0 || strcmp(line, "*e") == 0) {
+        refused++;
+        wasRefused = true;
+    }
+}
+
+static bool isTweet(const char *shown, const char *text) {                      //the firmware pads short tweets with spaces to the lcd width
+    size_t length = strlen(text);
+    return strncmp(shown, text, length) == 0 && strspn(shown + length, " ") == strlen(shown + length);
+}
+
+int main() {
+    static const char words[] = "the quick brown fox jumps over the lazy dog ";
+    static const int lengths[BURST] = {60, 280, 12, 140, 200, 90};
+    char texts[BURST][300];
+    simHostKeepAlive(1000);
+    simHostOnLine(onLine);
+    simSetAnalog(SPEEDPIN, 40);                                                 //20ms per scroll step
+    setup();
+    simHostTransfer(simMicros(), "$f01000");                                    //one second read time
+    for(int i = 0; i < BURST; i++) {
+        int start = sprintf(texts[i], "#%d ", i);
+        for(int j = start; j < lengths[i]; j++) {
+            texts[i][j] = words[(j - start) % (sizeof(words) - 1)];
+        }
+        texts[i][lengths[i]] = 0;
+    }
+    int next = 0;                                                               //next frame the host sends
+    uint64_t sendAt = simMicros();
+    unsigned long retries = 0;
+
+    //watch the lcd: which tweet is up, and whether its last LCDWIDTH chars made it onto the bottom row
+    int order[BURST];
+    bool reachedEnd[BURST] = {false};
+    uint64_t upAt[BURST] = {0};
+    int seen = 0;
+    int current = -1;
+    uint64_t end = simMicros() + 60000000ULL;
+    while(simMicros() < end && !(seen == BURST && reachedEnd[current])) {
+        loop();
+        if(wasRefused) {                                                        //the last frame didn't fit, send it again later
+            wasRefused = false;
+            next--;
+            retries++;
+            sendAt = simMicros() + 1000000;
+        }
+        if(next < BURST && simMicros() >= sendAt) {                             //the answer to a frame comes within 3ms of its last packet
+            sendAt = simHostFrame(simMicros(), "@TwiScnBench", texts[next++], false) + 3000;
+        }
+        const char *shown = twt.getTweet(true);
+        if(current < 0 || !isTweet(shown, texts[current])) {
+            for(int i = 0; i < BURST; i++) {
+                if(isTweet(shown, texts[i])) {
+                    current = i;
+                    order[seen++] = i;
+                    upAt[i] = simMicros();
+                }
+            }
+        }
+        if(current >= 0) {
+            const char *tail = texts[current] + (lengths[current] > 16 ? lengths[current] - 16 : 0);
+            if(strncmp(simLcdRow(1), tail, strlen(tail)) == 0) {
+                reachedEnd[current] = true;
+            }
+        }
+    }
+
+    printf("TwiScn burst of %d tweets: %lu refused while the queue was full, %lu resent\n", BURST, refused, retries);
+    printf("  %-6s %8s %12s %14s\n", "order", "chars", "up at ms", "scrolled to end");
+    for(int i = 0; i < seen; i++) {
+        int t = order[i];
+        printf("  #%-5d %8d %12.1f %14s\n", t, lengths[t], upAt[t] / 1000.0, reachedEnd[t] ? "yes" : "NO");
+    }
+
+    simHostTransfer(simMicros(), "$g1");                                        //the previous tweet is showing, so it can't make room
+    simRunFor(100);
+    refused = 0;
+    int sent = 0;
+    char transfer[302];
+    snprintf(transfer, sizeof(transfer), "!%s", texts[1]);                      //280 chars
+    while(!refused && sent < 10) {
+        uint64_t at = simHostTransfer(simMicros(), "@TwiScnBench");
+        simHostTransfer(at, transfer);
+        simRunFor(100);
+        sent++;
+    }
+    printf("legacy '!' transfers: %d sent, %lu kept, the one that didn't fit got \"*f\": %s\n", sent, sent - refused, refused ? "yes" : "NO");
+    bool ok = seen == BURST && refused;
+    for(int i = 0; i < seen; i++) {
+        ok = ok && order[i] == i && reachedEnd[i];
+    }
+    return !ok;                                                                 //non-zero if any check failed
+}
@@ -0,0 +1,75 @@
+//host blips: the host drops out, the device notices, and the host comes back at different points of the disconnect
+//notice and standby. reports how long from the host coming back until the tweet is on the lcd again and the backlight
+//is back where it was, and whether the host's options and the tweet survived
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../Options.h"
+#include "../../TweetHandler.h"
+
+extern Options opt;
+extern TweetHandler twt;
+extern IO inout;
+
+static bool noticeUp() {
+    return strncmp(simLcdRow(0), "Host has been", 13) == 0;
+}
+
+static bool tweetUp() {
+    return simLcdOn() && simLcdRow(1)[0] == 'z';                                //the tweet's text is back on the bottom row
+}
+
+static bool lightUp() {
+    return simGetPwm(REDLITE) > 0 && simGetPwm(BLUELITE) == simGetPwm(REDLITE) && !inout.fading();
+}
+
+static bool blip(const char *what, unsigned long awayMs, bool keep) {           //host stops, the device notices, host is back awayMs after the notice went up.
+                                                                                //false if it didn't come back, or the state wasn't kept when it should be
+    simHostAlive(false);
+    if(!simRunUntil(noticeUp, 30000)) {
+        printf("  %-28s host loss not noticed\n", what);
+        return false;
+    }
+    simRunFor(awayMs);
+    simHostAlive(true);
+    uint64_t back = simMicros();
+    bool tweet = simRunUntil(tweetUp, 15000);
+    double tweetMs = (simMicros() - back) / 1000.0;
+    bool light = tweet && simRunUntil(lightUp, 15000);
+    double lightMs = (simMicros() - back) / 1000.0;
+    byte *c = opt.getCol();
+    bool kept = c[0] == 255 && c[1] == 255 && c[2] == 255 && !opt.getScroll() && opt.getReadTime() == 1500 &&
+                twt.hasCurrent() && strcmp(twt.getUser(true), "blipper") == 0;
+    char tweetText[16];
+    char lightText[16];
+    sprintf(tweetText, tweet ? "%.0f" : "never", tweetMs);
+    sprintf(lightText, light ? "%.0f" : "never", lightMs);
+    printf("  %-28s %12s %14s %10s\n", what, tweetText, lightText, kept ? "yes" : "no");
+    simRunFor(3000);
+    return tweet && light && kept == keep;
+}
+
+int main() {
+    simHostKeepAlive(1000);
+    setup();
+    simRunFor(1000);
+    char text[80];
+    memset(text, 'z', sizeof(text) - 1);
+    text[sizeof(text) - 1] = 0;
+    uint64_t at = simHostFrame(simMicros(), "blipper", text, false);
+    at = simHostTransfer(at, "$b200");
+    at = simHostTransfer(at, "$c255255255");                                    //white, so red and blue match once it's back
+    at = simHostTransfer(at, "$f01500");
+    simHostTransfer(at, "$h0");                                                 //scroll paused, that one never gets saved
+    simRunFor(5000);
+
+    printf("TwiScn host blips, ms from the host coming back\n");
+    printf("  %-28s %12s %14s %10s\n", "host back", "tweet shown", "backlight back", "state kept");
+    bool ok = blip("during the notice", 1000, true);
+    ok &= blip("during the standby fade", 4500, true);
+    ok &= blip("with the lcd off", 10000, true);
+    ok &= blip("after 11 minutes", 660000, false);                              //past COLDAFTER, a fresh start
+    return !ok;                                                                 //non-zero if any check failed
+}
@@ -0,0 +1,94 @@
+//scroll rate under load: one long tweet scrolled with loop() running freely and with it getting stuck now and then,
+//the rate the lcd actually shows against the one the speed pot asks for
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+
+#define TEXTLEN 240
+#define POT 80                                                                  //speed 40, so a column every 41ms
+
+struct Load {
+    const char *name;
+    unsigned long stuckMs;                                                      //loop() gets stuck this long...
+    unsigned long everyMs;                                                      //...this often
+};
+
+static char text[TEXTLEN + 1];
+
+static int position() {                                                         //where in the text the bottom row is, -1 if it isn't showing it
+    const char *row = simLcdRow(1);
+    const char *at = strstr(text, row);
+    return at ? (int)(at - text) : -1;
+}
+
+static void run(const Load &load) {
+    static int tweet = 0;
+    char user[8];
+    sprintf(user, "run%d", tweet++);                                            //a new user each time so the tweet isn't a repeat
+    simHostFrame(simMicros(), user, text, false);
+    int last = TEXTLEN - 16;
+    int pos = -1;
+    int firstPos = -1;
+    uint64_t firstUs = 0;
+    uint64_t lastUs = 0;
+    unsigned long moves = 0;
+    uint64_t nextStuck = simMicros();
+    uint64_t end = simMicros() + 60000000ULL;
+    while(simMicros() < end && pos != last) {
+        loop();
+        int now = position();
+        if(now > 0 && now != pos) {
+            if(firstPos < 0) {
+                firstPos = now;
+                firstUs = simMicros();
+            }
+            moves++;
+            pos = now;
+            lastUs = simMicros();
+        }
+        if(load.stuckMs && simMicros() >= nextStuck) {
+            delay(load.stuckMs);
+            nextStuck = simMicros() + (uint64_t)load.everyMs * 1000;
+        }
+    }
+    double took = (lastUs - firstUs) / 1000.0;
+    double wanted = (double)(last - firstPos) * (POT / 2 + 1);
+    printf("  %-22s %8lu %10.0f %10.0f %8.1f%%\n", load.name, moves, took, wanted, took ? 100.0 * wanted / took : 0.0);
+    uint64_t wait = simMicros() + 2000000;                                      //let the read time at the end go by
+    while(simMicros() < wait) {
+        loop();
+    }
+}
+
+int main() {
+    for(int i = 0; i < TEXTLEN; i += 4) {                                       //"000 001 002 ...", so every lcd window is somewhere else in the text
+        char word[5];
+        sprintf(word, "%03d ", i / 4);
+        memcpy(text + i, word, 4);
+    }
+    text[TEXTLEN] = 0;
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, POT);
+    setup();
+    simHostTransfer(simMicros(), "$f00500");                                    //half a second read time
+    uint64_t end = simMicros() + 1000000;
+    while(simMicros() < end) {
+        loop();
+    }
+
+    static const Load loads[] = {
+        {"free running", 0, 0},
+        {"stuck 30ms every 100ms", 30, 100},
+        {"stuck 250ms every 1s", 250, 1000},
+        {"stuck 90ms every 100ms", 90, 100},
+    };
+    printf("TwiScn scroll rate, %d columns at %dms each\n", TEXTLEN - 16, POT / 2 + 1);
+    printf("  %-22s %8s %10s %10s %9s\n", "loop()", "moves", "took ms", "wanted ms", "rate");
+    for(unsigned int i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        run(loads[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+//usbPoll() gaps during the slow display sequences: boot, going to sleep, waking up, host loss and reconnect
+//V-USB needs polling well inside every 50ms or the host sees the device stall, so the worst gap is what matters here
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Sim.h"
+
+struct Phase {
+    const char *name;
+    uint64_t tookUs;
+    uint64_t worstGapUs;
+    unsigned long polls;
+};
+
+static void finish(Phase &p, uint64_t start) {
+    p.tookUs = simMicros() - start;
+    p.worstGapUs = simStats.maxPollGapUs;
+    p.polls = simStats.usbPolls;
+}
+
+static void printPhase(const Phase &p) {
+    printf("  %-14s %10.1f %14.1f %10lu\n", p.name, p.tookUs / 1000.0, p.worstGapUs / 1000.0, p.polls);
+}
+
+int main() {
+    Phase phases[] = {{"boot", 0, 0, 0}, {"sleep", 0, 0, 0}, {"wake", 0, 0, 0}, {"host lost", 0, 0, 0}};
+    simHostKeepAlive(1000);                                                     //the host program sends '%' every second
+    simSetAnalog(A0, 200);
+
+    //boot: setup() through the handshake, then a little normal running
+    simResetStats();
+    uint64_t start = simMicros();
+    setup();
+    simRunFor(1000);
+    finish(phases[0], start);
+    uint64_t at = simHostTransfer(simMicros(), "@TwiScnBench");
+    simHostTransfer(at, "!the quick brown fox jumps over the lazy dog, twice over");
+    simRunFor(1000);
+
+    //every host event is queued ahead of time, loop() may not return until it happens
+    //sleep: the host turns sleep mode on, covers the standby notice, backlight fade and sleeping
+    simResetStats();
+    start = simMicros();
+    simHostTransfer(start, "$s1");
+    simHostTransfer(start + 6000000, "$s0");
+    simRunFor(6000);
+    finish(phases[1], start);
+
+    //wake: sleep mode went off at the end of the last phase
+    simResetStats();
+    start = simMicros();
+    simRunFor(2000);
+    finish(phases[2], start);
+
+    //host lost: keepalives stop for 20s, covers the timeout, disconnect notice, sleep, warm reconnect and handshake
+    simResetStats();
+    start = simMicros();
+    simHostAlive(false);
+    simHostAliveAt(start + 20000000, true);
+    simRunFor(28000);
+    finish(phases[3], start);
+
+    printf("TwiScn usbPoll() gaps, times in virtual ms\n");
+    printf("  %-14s %10s %14s %10s\n", "phase", "took", "worst gap", "polls");
+    for(unsigned int i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        printPhase(phases[i]);
+    }
+    printf("LCD now: [%s] [%s]\n", simLcdRow(0), simLcdRow(1));
+    return 0;
+}
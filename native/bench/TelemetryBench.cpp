@@ -0,0 +1,109 @@
+//telemetry query: asks the device for its counters after a few different stretches and puts the reply next to what
+//the simulator itself saw, the simulator's poll gap also counts the usbPoll() calls HIDSerial makes while sending
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../Comms.h"
+
+struct Reply {
+    unsigned long loops;
+    unsigned long loopMean;
+    unsigned long loopMax;
+    unsigned long pollGap;
+    unsigned long keepAlives;
+    unsigned long packets;
+    unsigned long dropped;
+    unsigned long freeRam;
+};
+
+static Reply reply;
+static bool gotReply = false;
+static size_t replyLength = 0;
+
+static void onLine(uint64_t atUs, const char *line) {                           //decodes a '?' reply, see Comms.cpp
+    if(line[0] != '?') {
+        return;
+    }
+    const unsigned char *in = (const unsigned char *)line + 1;
+    static const int digits[] = {2, 2, 2, 2, 1, 2, 1, 1};
+    unsigned long *field = &reply.loops;
+    for(int f = 0; f < 8; f++) {
+        unsigned long value = 0;
+        for(int d = 0; d < digits[f]; d++) {
+            value = (value << 7) | (*in++ & 0x7F);
+        }
+        field[f] = value;
+    }
+    reply.freeRam *= 16;
+    if(reply.loopMax >= TIMEINMS) {                                             //long times come in ms
+        reply.loopMax = (reply.loopMax - TIMEINMS) * 1000;
+    }
+    if(reply.pollGap >= TIMEINMS) {
+        reply.pollGap = (reply.pollGap - TIMEINMS) * 1000;
+    }
+    replyLength = strlen(line);
+    gotReply = true;
+}
+
+static void runStuck(unsigned long ms, unsigned long stuckMs) {                 //stuckMs makes loop() get stuck that long every 500ms
+    uint64_t end = simMicros() + (uint64_t)ms * 1000;
+    uint64_t nextStuck = simMicros() + 500000;
+    while(simMicros() < end) {
+        loop();
+        if(stuckMs && simMicros() >= nextStuck) {
+            delay(stuckMs);
+            nextStuck += 500000;
+        }
+    }
+}
+
+static void query(const char *what) {                                           //sends '?' and prints the reply against the simulator's own figures
+    unsigned long packets = simStats.packetsIn + 2;                             //the query itself is two more
+    uint64_t gap = simStats.maxPollGapUs;
+    gotReply = false;
+    simHostTransfer(simMicros(), "?");
+    uint64_t end = simMicros() + 100000;
+    while(simMicros() < end && !gotReply) {
+        loop();
+    }
+    if(!gotReply) {
+        printf("  %-24s no reply\n", what);
+        return;
+    }
+    printf("  %-24s %7lu %7lu %7lu %7lu %7lu %7lu %7lu %7lu %7lu %7lu\n", what, reply.loops, reply.loopMean, reply.loopMax,
+           reply.pollGap, (unsigned long)gap, reply.keepAlives, reply.packets, packets, reply.dropped, reply.freeRam);
+    simResetStats();
+}
+
+int main() {
+    simHostOnLine(onLine);
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, 80);
+    setup();
+    simRunFor(1000);
+    query("(starts the count)");
+
+    printf("TwiScn telemetry query, counts since the one before\n");
+    printf("  %-24s %7s %7s %7s %7s %7s %7s %7s %7s %7s %7s\n", "over the last 5s", "loops", "mean us", "max us", "gap us",
+           "sim gap", "alives", "packets", "sim", "dropped", "free");
+    simRunFor(5000);
+    query("standby");
+    char text[TWEETSIZE + 1];
+    memset(text, 'x', TWEETSIZE);
+    text[TWEETSIZE] = 0;
+    simHostFrame(simMicros(), "scroller", text, false);
+    simRunFor(5000);
+    query("a tweet arriving");
+    runStuck(5000, 20);
+    query("stuck 20ms every 500ms");
+    char frame[SIM_FRAME_LEN];
+    simMakeFrame(frame, "broken", text, false);
+    memcpy(frame + 6, "1234", 4);                                               //a wrong crc, the whole frame gets refused
+    simHostPackets(simMicros(), frame);
+    simRunFor(5000);
+    query("a damaged frame");
+    printf("reply: %u chars plus the line end, %u reports\n", (unsigned int)replyLength, (unsigned int)(replyLength + 2 + 7) / 8);
+    return 0;
+}
@@ -0,0 +1,382 @@
+//HID trace replay: plays a recorded trace against the firmware and reports, per transfer, how long a tweet takes from
+//arriving to its first pixel on the lcd and an option from arriving to its first visible effect.
+//  TraceBench              records a scripted host session, then replays that recording
+//  TraceBench file         replays file (see HIDSerial.cpp for the format)
+//  TraceBench -r file      only records the scripted session into file
+//times are to within a loop() pass. options with nothing to see right away ('d', 'f', ...) show "-"
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../TweetHandler.h"
+
+extern TweetHandler twt;
+
+#define WATCHPWM 1                                                              //what an option shows up on
+#define WATCHROWS 2
+#define WATCHPOWER 4
+
+struct Transfer {
+    uint64_t atUs;                                                              //its last packet arrived, replay time
+    char kind;                                                                  //'t' tweet, '$' option, or the transfer type
+    std::string what;                                                           //user or option letters, for the report
+    int watch;                                                                  //WATCH* bits, 0 if nothing to wait for
+    bool refused;
+    bool seen;                                                                  //before state taken (options) or current on the lcd (tweets)
+    uint64_t doneUs;                                                            //first pixel or first effect, 0 until then
+    int pwm[3];
+    bool power;
+    std::string rows;
+    unsigned long writes;
+};
+
+static std::vector<Transfer> transfers;
+static std::string pendingUser;                                                 //from an '@' transfer, the '!' after it finishes the tweet
+static bool gotUser = false;
+static std::vector<std::string> replayLines;
+
+//==============================================================================
+//the scripted session, with the host model doing the handshake and keepalives
+
+static void session() {
+    char text[TWEETSIZE + 1];
+    for(int i = 0; i < TWEETSIZE; i++) {
+        text[i] = 'a' + i % 26;
+    }
+    text[TWEETSIZE] = 0;
+    simTraceRecord(true);
+    simHostFrame(simMicros(), "alice", text + 80, false);                       //200 chars, it scrolls
+    simRunFor(500);
+    uint64_t at = simHostTransfer(simMicros(), "@bob");                         //an old style pair, waits for alice to finish
+    simHostTransfer(at, "!short one");
+    simRunFor(2000);
+    simHostTransfer(simMicros(), "$b120");
+    simRunFor(1000);
+    simHostTransfer(simMicros(), "$c255040000");
+    simRunFor(1000);
+    simHostTransfer(simMicros(), "$f01500");
+    simRunFor(1000);
+    simHostTransfer(simMicros(), "$h0");                                        //scroll paused
+    simRunFor(1500);
+    simHostTransfer(simMicros(), "$h1");
+    simRunFor(12000);
+    simHostFrame(simMicros(), "carol", text + 200, false);
+    simRunFor(3000);
+    simHostTransfer(simMicros(), "$g1");                                        //previous tweet
+    simRunFor(1500);
+    simHostTransfer(simMicros(), "$g0");
+    simRunFor(1500);
+    simHostTransfer(simMicros(), "$s1");                                        //sleep
+    simRunFor(2000);
+    simHostTransfer(simMicros(), "$s0");
+    simRunFor(2000);
+    simHostTransfer(simMicros(), "?");
+    simRunFor(500);
+    simHostFrame(simMicros(), "dave", text, false);
+    simRunFor(4000);
+    simTraceRecord(false);
+}
+
+//==============================================================================
+//working out the transfers from the host's packets, the same way Comms reassembles them
+
+static int watchFor(char type) {                                                //where an option shows up
+    switch(type) {
+        case 'b':
+        case 'c':
+        case 'e':
+            return WATCHPWM;
+        case 'g':
+        case 'h':
+            return WATCHROWS;
+        case 's':                                                               //a notice goes up before the lcd goes off
+            return WATCHROWS | WATCHPOWER;
+    }
+    return 0;
+}
+
+static int optionSize(char type) {                                              //binary payload sizes, Options::payloadSize()
+    switch(type) {
+        case 'b':
+        case 'g':
+        case 'h':
+        case 's':
+            return 1;
+        case 'c':
+        case 'e':
+            return 3;
+        case 'd':
+            return 5;
+        case 'f':
+            return 2;
+    }
+    return 0;
+}
+
+static void addTransfer(uint64_t atUs, const std::string &data) {               //a finished '=' transfer
+    Transfer t = Transfer();
+    t.atUs = atUs;
+    t.kind = data[0];
+    if(t.kind == '@') {                                                         //the '!' that follows makes it a tweet
+        pendingUser = data.substr(1, USERSIZE);
+        gotUser = true;
+        return;
+    }
+    if(t.kind == '!') {
+        if(!gotUser) {
+            return;
+        }
+        t.kind = 't';
+        t.what = pendingUser;
+        gotUser = false;
+    }
+    else if(t.kind == '$' && data.size() > 1 && (unsigned char)data[1] == 0x81) {  //binary, undo the byte stuffing and look at every record
+        std::string raw;
+        for(size_t i = 2; i < data.size();) {
+            unsigned char code = data[i++];
+            for(int j = 1; j < code && i < data.size(); j++) {
+                raw += data[i++];
+            }
+            if(code != 0xFF && i < data.size()) {
+                raw += '\0';
+            }
+        }
+        for(size_t i = 0; i < raw.size() && optionSize(raw[i]);) {
+            t.what += raw[i];
+            t.watch |= watchFor(raw[i]);
+            i += optionSize(raw[i]) + 1;
+        }
+    }
+    else if(t.kind == '$' && data.size() > 1) {
+        t.what = data.substr(1, 1);
+        t.watch = watchFor(data[1]);
+    }
+    transfers.push_back(t);
+}
+
+static void findTransfers(uint64_t startUs) {
+    std::string transfer;
+    size_t frameLeft = 0;
+    Transfer frame;
+    for(unsigned long i = 0; i < simTraceLength(); i++) {
+        const SimTraceEntry &e = simTraceEntry(i);
+        if(!e.fromHost) {
+            continue;
+        }
+        std::string data = e.data;
+        uint64_t at = startUs + e.atUs;
+        if(frameLeft) {
+            if(data != "%") {
+                frameLeft -= data.size() < frameLeft ? data.size() : frameLeft;
+                if(!frameLeft) {
+                    frame.atUs = at;
+                    transfers.push_back(frame);
+                }
+            }
+            continue;
+        }
+        unsigned int user;
+        unsigned int text;
+        unsigned int crc;
+        if(transfer.empty() && (data[0] == '*' || data[0] == '&') && data.size() >= 10 && sscanf(data.c_str() + 1, "%2x%3x%4x", &user, &text, &crc) == 3) {
+            frame = Transfer();
+            frame.kind = 't';
+            gotUser = false;                                                    //a frame replaces a '@' still waiting for its '!'
+            frame.what = data.substr(10, user);                                 //the header and user are always in the first packet
+            frameLeft = user + text;
+            size_t first = data.size() - 10 < frameLeft ? data.size() - 10 : frameLeft;
+            frameLeft -= first;
+            if(!frameLeft) {
+                frame.atUs = at;
+                transfers.push_back(frame);
+            }
+        }
+        else if(data == "=") {
+            if(!transfer.empty()) {
+                addTransfer(at, transfer);
+            }
+            transfer.clear();
+        }
+        else if(data != "%" && data != "~") {
+            transfer += data;
+        }
+    }
+}
+
+//==============================================================================
+//the replay
+
+static void onLine(uint64_t atUs, const char *line) {
+    replayLines.push_back(line);
+    if(strcmp(line, "*e") == 0 || strcmp(line, "*f") == 0 || strcmp(line, "*l") == 0) {  //the latest tweet frame that came in got refused
+        for(size_t i = transfers.size(); i > 0; i--) {
+            Transfer &t = transfers[i - 1];
+            if(t.kind == 't' && t.atUs <= atUs) {
+                t.refused = true;
+                break;
+            }
+        }
+    }
+}
+
+static std::string current() {                                                  //what the current tweet is, changes when the next one goes up
+    if(!twt.hasCurrent()) {
+        return "";
+    }
+    return std::string(twt.getUser(true)) + '\n' + twt.getTweet(true);
+}
+
+static std::string rows() {
+    return std::string(simLcdRow(0)) + simLcdRow(1);
+}
+
+static void snapshot(Transfer &t) {                                             //how things look before an option arrives
+    t.pwm[0] = simGetPwm(REDLITE);
+    t.pwm[1] = simGetPwm(GREENLITE);
+    t.pwm[2] = simGetPwm(BLUELITE);
+    t.power = simLcdOn();
+    t.rows = rows();
+}
+
+static bool changed(const Transfer &t) {
+    if((t.watch & WATCHPWM) && (t.pwm[0] != simGetPwm(REDLITE) || t.pwm[1] != simGetPwm(GREENLITE) || t.pwm[2] != simGetPwm(BLUELITE))) {
+        return true;
+    }
+    if((t.watch & WATCHPOWER) && t.power != simLcdOn()) {
+        return true;
+    }
+    return (t.watch & WATCHROWS) && t.rows != rows();
+}
+
+static void replay() {
+    simHostKeepAlive(0);                                                        //the trace has the keepalives
+    uint64_t start = simMicros();                                               //a recording from this bench started at the same point, so it should play out the same
+    findTransfers(start);
+    simTraceReplay(start);
+    uint64_t end = start + (simTraceLength() ? simTraceEntry(simTraceLength() - 1).atUs : 0) + 5000000;
+    std::string shown = current();
+    while(simMicros() < end) {
+        for(size_t i = 0; i < transfers.size(); i++) {                          //options: the state just before the pass that reads them
+            Transfer &t = transfers[i];
+            if(t.kind == '$' && !t.seen && t.atUs <= simMicros()) {
+                snapshot(t);
+                t.seen = true;
+            }
+        }
+        unsigned long writes = simStats.lcdWrites;
+        loop();
+        std::string now = current();
+        if(now != shown) {                                                      //the next tweet went up, it's the oldest one still waiting
+            shown = now;
+            std::string user = now.substr(0, now.find('\n'));
+            for(size_t i = 0; i < transfers.size(); i++) {
+                Transfer &t = transfers[i];
+                if(t.kind == 't' && !t.seen && !t.refused && t.what == user) {
+                    t.seen = true;
+                    t.writes = writes;                                          //its first pixel is the first lcd write from this pass on
+                    break;
+                }
+            }
+        }
+        for(size_t i = 0; i < transfers.size(); i++) {
+            Transfer &t = transfers[i];
+            if(!t.seen || t.doneUs) {
+                continue;
+            }
+            if(t.kind == 't' && simStats.lcdWrites > t.writes) {
+                t.doneUs = simMicros();
+            }
+            else if(t.kind == '$' && t.watch && changed(t)) {
+                t.doneUs = simMicros();
+            }
+        }
+    }
+
+    printf("  %-4s %10s %-6s %-12s %12s\n", "#", "at ms", "type", "what", "latency ms");
+    for(size_t i = 0; i < transfers.size(); i++) {
+        Transfer &t = transfers[i];
+        char latency[24];
+        if(t.refused) {
+            strcpy(latency, "refused");
+        }
+        else if(t.doneUs) {
+            sprintf(latency, "%.1f", (t.doneUs - t.atUs) / 1000.0);
+        }
+        else if(t.kind == 't' || t.watch) {
+            strcpy(latency, "never");
+        }
+        else {
+            strcpy(latency, "-");
+        }
+        const char *type = t.kind == 't' ? "tweet" : t.kind == '$' ? "option" : "other";
+        std::string what = t.kind == 't' ? t.what : std::string(1, t.kind) + t.what;
+        printf("  %-4u %10.1f %-6s %-12s %12s\n", (unsigned int)i, (t.atUs - start) / 1000.0, type, what.c_str(), latency);
+    }
+    unsigned long recorded = 0;
+    unsigned long same = 0;
+    size_t next = 0;
+    for(unsigned long i = 0; i < simTraceLength(); i++) {                       //the lines the device printed, in order, against the trace's
+        const SimTraceEntry &e = simTraceEntry(i);
+        if(e.fromHost) {
+            continue;
+        }
+        recorded++;
+        if(next < replayLines.size() && replayLines[next] == e.data) {
+            same++;
+            next++;
+        }
+    }
+    printf("device lines: %lu in the trace, %u in the replay, %lu the same and in the same order\n", recorded,
+           (unsigned int)replayLines.size(), same);
+}
+
+int main(int argc, char **argv) {
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, 80);
+    setup();
+    simRunFor(1000);
+    if(argc > 2 && strcmp(argv[1], "-r") == 0) {
+        session();
+        return simTraceSave(argv[2]) ? 0 : 1;
+    }
+    if(argc > 1) {
+        if(!simTraceLoad(argv[1])) {
+            printf("can't read trace %s\n", argv[1]);
+            return 1;
+        }
+        printf("TwiScn trace replay, %s, %lu entries\n", argv[1], simTraceLength());
+    }
+    else {                                                                      //record the script in a copy of this process, then replay it from the same start
+        char path[] = "/tmp/TraceBenchXXXXXX";
+        int fd = mkstemp(path);
+        if(fd < 0) {
+            printf("can't write a trace to /tmp\n");
+            return 1;
+        }
+        close(fd);
+        fflush(stdout);
+        pid_t child = fork();
+        if(child == 0) {
+            session();
+            _exit(simTraceSave(path) ? 0 : 1);
+        }
+        int status = 1;
+        waitpid(child, &status, 0);
+        bool loaded = status == 0 && simTraceLoad(path);
+        unlink(path);
+        if(!loaded) {
+            printf("recording the session failed\n");
+            return 1;
+        }
+        printf("TwiScn trace replay, scripted session, %lu entries\n", simTraceLength());
+    }
+    simHostOnLine(onLine);
+    replay();
+    return 0;
+}
@@ -0,0 +1,69 @@
+//heap use of the comms receive path: feeds a 280 character tweet through Comms::readComms() packet by packet
+//and counts the malloc/realloc calls made while each packet is handled
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../Comms.h"
+
+extern Comms comms;
+
+struct PacketCount {
+    unsigned long packets;
+    unsigned long allocs;
+    unsigned long worst;                                                        //most allocations made by a single packet
+};
+
+static void count(PacketCount &c, unsigned long allocs) {
+    c.packets++;
+    c.allocs += allocs;
+    if(allocs > c.worst) {
+        c.worst = allocs;
+    }
+}
+
+static void sendPacket(const char *packet, PacketCount &c) {                   //queues one packet and polls until the firmware handled it
+    simHostPacket(simMicros(), packet);
+    unsigned long packetsIn = simStats.packetsIn;
+    unsigned long allocs = simStats.heapAllocs;
+    while(simStats.packetsIn == packetsIn) {
+        comms.readComms();
+    }
+    count(c, simStats.heapAllocs - allocs);
+}
+
+static void sendTransfer(const char *data, PacketCount &dataPackets, PacketCount &terminators) {
+    char packet[32];
+    unsigned int length = strlen(data);
+    for(unsigned int i = 0; i < length; i += 31) {
+        strncpy(packet, data + i, 31);
+        packet[31] = 0;
+        sendPacket(packet, dataPackets);
+    }
+    sendPacket("=", terminators);
+}
+
+int main(int argc, char **argv) {
+    int tweets = argc > 1 ? atoi(argv[1]) : 10;
+    char tweet[300];
+    tweet[0] = '!';
+    for(int i = 1; i <= 280; i++) {
+        tweet[i] = 'a' + (i % 26);
+    }
+    tweet[281] = 0;
+
+    PacketCount dataPackets = {0, 0, 0};
+    PacketCount terminators = {0, 0, 0};
+    simResetStats();
+    for(int i = 0; i < tweets; i++) {
+        sendTransfer("@TwiScnBench", dataPackets, terminators);
+        sendTransfer(tweet, dataPackets, terminators);
+    }
+    printf("TwiScn receive path, %d tweets of 280 characters\n", tweets);
+    printf("  data packets: %lu, %lu allocations (%.2f per packet, worst %lu)\n", dataPackets.packets,
+           dataPackets.allocs, (double)dataPackets.allocs / dataPackets.packets, dataPackets.worst);
+    printf("  terminators:  %lu, %lu allocations (%.2f per transfer, worst %lu)\n", terminators.packets,
+           terminators.allocs, (double)terminators.allocs / terminators.packets, terminators.worst);
+    printf("  per tweet:    %.1f allocations\n", (double)(dataPackets.allocs + terminators.allocs) / tweets);
+    return 0;
+}
@@ -0,0 +1,104 @@
+//EEPROM tweet log: pushes a long run of tweets of random length through, one a minute, and reports how evenly the log
+//wears its cells and how long it lasts at that rate. then checks what a power cycle comes back with, also when one cuts
+//a record off halfway and when the last tweet came too soon after the last record to be logged
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "../../IO.h"
+#include "../../Comms.h"
+#include "../../TweetHandler.h"
+
+extern TweetHandler twt;
+extern Comms comms;
+void prepare();
+
+#define TWEETS 1000
+#define TWEETGAP 60000                                                          //ms from one tweet to the next
+#define ENDURANCE 100000UL                                                      //writes an atmega328p EEPROM cell is rated for
+
+static bool showing(const char *user) {                                         //the user row has user on it
+    return strncmp(simLcdRow(0), user, strlen(user)) == 0;
+}
+
+static void tweet(int n, char *user) {                                          //a random tweet from user<n>, returns once it's on the lcd
+    char text[TWEETSIZE + 1];
+    unsigned int length = 20 + rand() % (TWEETSIZE - 19);
+    for(unsigned int i = 0; i < length; i++) {
+        text[i] = 'a' + rand() % 26;
+    }
+    text[length] = 0;
+    sprintf(user, "user%d", n);
+    simHostFrame(simMicros(), user, text, false);
+    uint64_t end = simMicros() + 30000000ULL;
+    while(simMicros() < end && !showing(user)) {
+        loop();
+    }
+}
+
+static const char *restored() {                                                 //what a fresh TweetHandler gets out of the log
+    static TweetHandler fresh(16);
+    fresh = TweetHandler(16);
+    fresh.restore();
+    return fresh.hasCurrent() ? fresh.getUser(true) : "(nothing)";
+}
+
+int main() {
+    srand(1);
+    simHostKeepAlive(1000);
+    simSetAnalog(SPEEDPIN, 0);                                                  //fastest scroll, a column a ms
+    setup();
+    simHostTransfer(simMicros(), "$f01000");                                    //a second of read time at each end
+    simRunFor(4000);
+
+    unsigned long writesBefore = simStats.eepromWrites;
+    uint64_t start = simMicros();
+    char user[16];
+    for(int n = 0; n < TWEETS; n++) {
+        uint64_t at = simMicros();
+        tweet(n, user);
+        simRunFor(TWEETGAP - (simMicros() - at) / 1000);
+    }
+    unsigned long writes = simStats.eepromWrites - writesBefore;
+    double days = (simMicros() - start) / 86400e6;
+
+    unsigned long low = ~0UL;
+    unsigned long high = 0;
+    unsigned long total = 0;
+    for(int a = LOGADDR; a < LOGADDR + LOGSIZE; a++) {
+        unsigned long w = simEepromWear(a);
+        low = w < low ? w : low;
+        high = w > high ? w : high;
+        total += w;
+    }
+    printf("TwiScn tweet log, %d tweets of 20-%d chars one a minute, %d byte log, a record every %lu minutes at most\n",
+           TWEETS, TWEETSIZE, LOGSIZE, LOGEVERY / 60000);
+    printf("  EEPROM writes: %lu, %.1f per tweet\n", writes, (double)writes / TWEETS);
+    printf("  %-24s %8s %8s %8s %14s\n", "writes per cell", "least", "mean", "most", "years to wear");
+    printf("  %-24s %8lu %8.1f %8lu %14.1f\n", "tweet log", low, (double)total / LOGSIZE, high, ENDURANCE * days / high / 365);
+    printf("  %-24s %8d %8d %8d %14.1f\n", "one fixed slot, each tweet", TWEETS, TWEETS, TWEETS, ENDURANCE * days / TWEETS / 365);
+
+    simRunFor(LOGEVERY + 5000);                                                 //the last tweet gets its record
+    printf("  %-34s %-10s %-10s\n", "power cycle", "expected", "restored");
+    printf("  %-34s %-10s %-10s\n", "after the last record", user, restored());
+    simRunFor(LOGEVERY);                                                        //so the next tweet's record starts right away
+    char last[16];
+    strcpy(last, user);
+    tweet(TWEETS, user);
+    simRunFor(100);                                                             //the power goes a few bytes into the record
+    printf("  %-34s %-10s %-10s\n", "partway into the next record", last, restored());
+    simRunFor(5000);
+    strcpy(last, user);
+    tweet(TWEETS + 1, user);
+    simRunFor(5000);
+    printf("  %-34s %-10s %-10s\n", "a tweet too soon after the record", last, restored());
+
+    twt = TweetHandler(16);                                                     //power cycle for real: empty ram, boot animation, handshake
+    twt.restore();
+    comms.setConnected(false);
+    prepare();
+    simRunFor(500);
+    printf("lcd after the handshake: \"%.16s\" %s\n", simLcdRow(0), showing(last) ? "(the last logged tweet)" : "(not the last logged tweet)");
+    return 0;
+}
@@ -0,0 +1,14 @@
+//Linux stand-in for the V-USB driver header
+#ifndef USBDRV_H
+#define	USBDRV_H
+
+typedef unsigned char uchar;
+
+#define USB_COUNT_SOF 1                                                         //on the board this comes from usbconfig.h
+
+void usbPoll();
+uchar simSofCount();
+#define usbSofCount simSofCount()                                               //start of frame count, follows the virtual clock while the bus is up
+
+#endif	/* USBDRV_H */
+
@@ -0,0 +1,20 @@
+//Linux stand-in for avr-libc's util/crc16.h, same results as the optimized AVR versions
+#ifndef UTIL_CRC16_H
+#define	UTIL_CRC16_H
+
+#include <stdint.h>
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data) {        //CRC-16/XMODEM, polynomial 0x1021
+    crc = crc ^ ((uint16_t)data << 8);
+    for(int i = 0; i < 8; i++) {
+        if(crc & 0x8000) {
+            crc = (crc << 1) ^ 0x1021;
+        }
+        else {
+            crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+#endif	/* UTIL_CRC16_H */
@@ -39,6 +39,9 @@ OBJECTFILES= \
 	${OBJECTDIR}/IO.o \
 	${OBJECTDIR}/LCDControl.o \
 	${OBJECTDIR}/Options.o \
+	${OBJECTDIR}/Profiler.o \
+	${OBJECTDIR}/Scheduler.o \
+	${OBJECTDIR}/TextPack.o \
 	${OBJECTDIR}/TweetHandler.o \
 	${OBJECTDIR}/main.o
 
@@ -92,6 +95,21 @@ ${OBJECTDIR}/TweetHandler.o: TweetHandler.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -I${INCLUDE} -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TweetHandler.o TweetHandler.cpp
 
+${OBJECTDIR}/Scheduler.o: Scheduler.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -I${INCLUDE} -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/Scheduler.o Scheduler.cpp
+
+${OBJECTDIR}/Profiler.o: Profiler.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -I${INCLUDE} -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/Profiler.o Profiler.cpp
+
+${OBJECTDIR}/TextPack.o: TextPack.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -I${INCLUDE} -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TextPack.o TextPack.cpp
+
 ${OBJECTDIR}/main.o: main.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"